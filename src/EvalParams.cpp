@@ -0,0 +1,57 @@
+#include "EvalParams.hpp"
+#include <charconv>
+#include <fstream>
+
+EvalParams default_eval_params;
+
+std::vector<std::pair<const char*, int*>> EvalParams::fields() {
+    return {
+        {"live_4", &live_4},
+        {"dead_4", &dead_4},
+        {"live_3", &live_3},
+        {"dead_3", &dead_3},
+        {"live_2", &live_2},
+        {"attack_bias", &attack_bias},
+        {"move_win", &move_win},
+        {"move_block_win", &move_block_win},
+        {"move_block_4", &move_block_4},
+        {"move_make_4", &move_make_4},
+        {"move_make_3", &move_make_3},
+        {"move_block_3", &move_block_3},
+        {"move_center", &move_center},
+    };
+}
+
+bool EvalParams::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+    auto named = fields();
+    for (std::string line; std::getline(in, line);) {
+        if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = line.substr(0, eq);
+        for (auto& [name, field] : named) {
+            if (key != name) continue;
+            int value;
+            auto res = std::from_chars(line.data() + eq + 1, line.data() + line.size(), value);
+            if (res.ec == std::errc()) *field = value;
+        }
+    }
+    return true;
+}
+
+bool EvalParams::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    EvalParams copy = *this;
+    for (auto& [name, field] : copy.fields()) out << name << "=" << *field << "\n";
+    return static_cast<bool>(out);
+}
+
+bool load_eval_params(const std::string& path) {
+    EvalParams params;
+    if (!params.load(path)) return false;
+    default_eval_params = params;
+    return true;
+}
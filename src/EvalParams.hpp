@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Weights of the hand-tuned evaluator (eval_state) and of the tactical part
+// of move ordering (score_move). Defaults are the original hand-picked values;
+// gomoku-tune fits them to a position corpus.
+struct EvalParams {
+    // eval_state: per line of stones, by length and open ends
+    int live_4 = 1000000; // Win Guaranteed
+    int dead_4 = 15000;   // Win next turn if not blocked (Check)
+    int live_3 = 8000;    // Create live_4 next turn (Checkmate threat)
+    int dead_3 = 500;
+    int live_2 = 100;
+    int attack_bias = 110; // percent applied to the side to move's lines
+
+    // score_move: what playing the cell does in its best direction
+    int move_win = 100000000;
+    int move_block_win = 90000000;
+    int move_block_4 = 2000000;
+    int move_make_4 = 1000000;
+    int move_make_3 = 20000;
+    int move_block_3 = 15000;
+    int move_center = 10; // penalty per cell of Manhattan distance from the center
+
+    // Stored as "name=value" lines; unknown names are ignored
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Name and address of every field, for the tuner and the file format
+    std::vector<std::pair<const char*, int*>> fields();
+};
+
+// Parameters every new GomokuAI starts from
+extern EvalParams default_eval_params;
+bool load_eval_params(const std::string& path);
@@ -0,0 +1,302 @@
+#include "GameDB.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t GAMES_VERSION = 1;
+static constexpr uint32_t INDEX_VERSION = 1;
+static constexpr size_t GAMES_HEADER = 8;
+static constexpr size_t INDEX_HEADER = 32;
+
+template <typename T>
+static void put(std::vector<uint8_t>& buf, T value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// --- WRITER ---
+
+GameWriter::~GameWriter() {
+    close();
+}
+
+bool GameWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "ab+");
+    if (!file) return false;
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        std::fwrite("GGDB", 1, 4, file);
+        std::fwrite(&GAMES_VERSION, sizeof(GAMES_VERSION), 1, file);
+        return std::fflush(file) == 0;
+    }
+
+    char magic[4];
+    uint32_t version;
+    std::rewind(file);
+    if (std::fread(magic, 1, 4, file) != 4 || std::memcmp(magic, "GGDB", 4) != 0 ||
+        std::fread(&version, sizeof(version), 1, file) != 1 || version != GAMES_VERSION) {
+        close();
+        return false;
+    }
+
+    // Drop a record torn by a crash, so new games are not appended behind it
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    long pos = static_cast<long>(GAMES_HEADER);
+    for (uint32_t bytes; pos + 4 <= size; pos += 4 + static_cast<long>(bytes)) {
+        if (std::fseek(file, pos, SEEK_SET) != 0 || std::fread(&bytes, sizeof(bytes), 1, file) != 1 ||
+            pos + 4 + static_cast<long>(bytes) > size) {
+            break;
+        }
+    }
+    if (pos < size && ftruncate(fileno(file), pos) != 0) {
+        close();
+        return false;
+    }
+    return std::fseek(file, 0, SEEK_END) == 0;
+}
+
+bool GameWriter::append(const GameRecord& game) {
+    if (!file || game.first.size() > 255 || game.second.size() > 255 || game.moves.size() > 0xFFFF) return false;
+    buf.clear();
+    put<uint32_t>(buf, 0); // record_bytes, patched below
+    put<uint16_t>(buf, static_cast<uint16_t>(game.board_size));
+    put<int8_t>(buf, game.result);
+    put<uint8_t>(buf, 0);
+    put<uint64_t>(buf, game.timestamp);
+    put<uint8_t>(buf, static_cast<uint8_t>(game.first.size()));
+    put<uint8_t>(buf, static_cast<uint8_t>(game.second.size()));
+    buf.insert(buf.end(), game.first.begin(), game.first.end());
+    buf.insert(buf.end(), game.second.begin(), game.second.end());
+    put<uint16_t>(buf, static_cast<uint16_t>(game.moves.size()));
+    for (uint16_t m : game.moves) put<uint16_t>(buf, m);
+    uint32_t bytes = static_cast<uint32_t>(buf.size() - 4);
+    std::memcpy(buf.data(), &bytes, 4);
+
+    return std::fwrite(buf.data(), 1, buf.size(), file) == buf.size() && std::fflush(file) == 0;
+}
+
+bool GameWriter::close() {
+    if (!file) return true;
+    bool ok = std::ferror(file) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+// --- RECORD PARSING ---
+
+// Parses the record at `pos`; false if it is truncated or malformed
+static bool parse_game(const uint8_t* data, size_t size, size_t pos, GameRecord& g, size_t& next) {
+    if (pos + 4 > size) return false;
+    uint32_t bytes = get<uint32_t>(data + pos);
+    const uint8_t* p = data + pos + 4;
+    const uint8_t* end = p + bytes;
+    if (bytes < 16 || bytes > size - pos - 4) return false;
+
+    g.board_size = get<uint16_t>(p);
+    g.result = get<int8_t>(p + 2);
+    g.timestamp = get<uint64_t>(p + 4);
+    size_t first_len = p[12], second_len = p[13];
+    p += 14;
+    if (p + first_len + second_len + 2 > end) return false;
+    g.first.assign(reinterpret_cast<const char*>(p), first_len);
+    g.second.assign(reinterpret_cast<const char*>(p + first_len), second_len);
+    p += first_len + second_len;
+    size_t count = get<uint16_t>(p);
+    p += 2;
+    if (p + count * 2 != end) return false;
+    g.moves.resize(count);
+    std::memcpy(g.moves.data(), p, count * 2);
+    next = pos + 4 + bytes;
+    return true;
+}
+
+// --- DATABASE ---
+
+static void* map_file(const std::string& path, size_t& size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void* data = nullptr;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = static_cast<size_t>(st.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) data = nullptr;
+    }
+    ::close(fd);
+    return data;
+}
+
+GameDB::~GameDB() {
+    close();
+}
+
+void GameDB::close() {
+    for (Mapping* m : {&games_map, &index_map}) {
+        if (m->data) munmap(m->data, m->size);
+        *m = Mapping();
+    }
+    game_count = entry_count = 0;
+    offsets = nullptr;
+    entries = nullptr;
+    own_offsets.clear();
+    own_entries.clear();
+}
+
+bool GameDB::open(const std::string& path) {
+    close();
+    games_map.data = map_file(path, games_map.size);
+    const uint8_t* data = static_cast<const uint8_t*>(games_map.data);
+    if (!data || games_map.size < GAMES_HEADER || std::memcmp(data, "GGDB", 4) != 0 ||
+        get<uint32_t>(data + 4) != GAMES_VERSION) {
+        close();
+        return false;
+    }
+    madvise(games_map.data, games_map.size, MADV_RANDOM);
+    if (!update_index(path + ".idx")) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+uint64_t GameDB::stone_key(int board_size, int idx, int player) {
+    uint64_t z = (static_cast<uint64_t>(board_size) << 32 | (static_cast<uint64_t>(idx) * 3 + player))
+               + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t GameDB::position_key(const GomokuAI& ai) {
+    uint64_t key = 0;
+    for (int idx = 0; idx < ai.width * ai.height; ++idx) {
+        if (ai.board[idx] != 0) key ^= stone_key(ai.width, idx, ai.board[idx]);
+    }
+    return key;
+}
+
+// Maps the index file; if it misses games appended since, indexes them and
+// merges them in, rewriting the file (or keeping the result in memory when
+// the file cannot be written).
+bool GameDB::update_index(const std::string& index_path) {
+    const uint8_t* data = static_cast<const uint8_t*>(games_map.data);
+    size_t indexed_bytes = GAMES_HEADER;
+
+    index_map.data = map_file(index_path, index_map.size);
+    const uint8_t* idx = static_cast<const uint8_t*>(index_map.data);
+    if (idx && index_map.size >= INDEX_HEADER && std::memcmp(idx, "GGDX", 4) == 0 &&
+        get<uint32_t>(idx + 4) == INDEX_VERSION) {
+        uint64_t bytes = get<uint64_t>(idx + 8);
+        uint64_t games = get<uint64_t>(idx + 16);
+        uint64_t count = get<uint64_t>(idx + 24);
+        if (bytes >= GAMES_HEADER && bytes <= games_map.size &&
+            games <= (index_map.size - INDEX_HEADER) / 8 &&
+            count == (index_map.size - INDEX_HEADER - games * 8) / sizeof(IndexEntry) &&
+            index_map.size == INDEX_HEADER + games * 8 + count * sizeof(IndexEntry)) {
+            indexed_bytes = bytes;
+            game_count = games;
+            entry_count = count;
+            offsets = reinterpret_cast<const uint64_t*>(idx + INDEX_HEADER);
+            entries = reinterpret_cast<const IndexEntry*>(idx + INDEX_HEADER + games * 8);
+        }
+    }
+    if (!offsets) {
+        if (index_map.data) munmap(index_map.data, index_map.size);
+        index_map = Mapping();
+    }
+
+    // Index the games past indexed_bytes
+    std::vector<uint64_t> new_offsets;
+    std::vector<IndexEntry> new_entries;
+    size_t pos = indexed_bytes;
+    GameRecord g;
+    for (size_t next; parse_game(data, games_map.size, pos, g, next); pos = next) {
+        uint32_t game = static_cast<uint32_t>(game_count + new_offsets.size());
+        new_offsets.push_back(pos);
+        int cells = g.board_size * g.board_size;
+        uint64_t key = 0;
+        for (size_t ply = 0; ply < g.moves.size() && g.moves[ply] < cells; ++ply) {
+            key ^= stone_key(g.board_size, g.moves[ply], ply % 2 == 0 ? 1 : 2);
+            new_entries.push_back({key, game, static_cast<uint32_t>(ply + 1)});
+        }
+    }
+    if (new_offsets.empty() && offsets) return true;
+
+    auto by_key = [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.game != b.game ? a.game < b.game : a.ply < b.ply;
+    };
+    std::sort(new_entries.begin(), new_entries.end(), by_key);
+
+    // Old entries all belong to earlier games, so a merge keeps (key, game, ply) order
+    std::string tmp = index_path + ".tmp";
+    std::FILE* out = std::fopen(tmp.c_str(), "wb");
+    bool written = false;
+    if (out) {
+        std::setvbuf(out, nullptr, _IOFBF, 1 << 20);
+        uint64_t header[3] = {pos, game_count + new_offsets.size(), entry_count + new_entries.size()};
+        std::fwrite("GGDX", 1, 4, out);
+        std::fwrite(&INDEX_VERSION, sizeof(INDEX_VERSION), 1, out);
+        std::fwrite(header, sizeof(header), 1, out);
+        std::fwrite(offsets, sizeof(uint64_t), game_count, out);
+        std::fwrite(new_offsets.data(), sizeof(uint64_t), new_offsets.size(), out);
+        size_t i = 0, j = 0;
+        while (i < entry_count || j < new_entries.size()) {
+            bool take_old = j == new_entries.size() || (i < entry_count && entries[i].key <= new_entries[j].key);
+            std::fwrite(take_old ? &entries[i++] : &new_entries[j++], sizeof(IndexEntry), 1, out);
+        }
+        written = std::ferror(out) == 0;
+        written = std::fclose(out) == 0 && written;
+        written = written && std::rename(tmp.c_str(), index_path.c_str()) == 0;
+        if (!written) std::remove(tmp.c_str());
+    }
+
+    if (!written) {
+        own_offsets.assign(offsets, offsets + game_count);
+        own_offsets.insert(own_offsets.end(), new_offsets.begin(), new_offsets.end());
+        own_entries.resize(entry_count + new_entries.size());
+        std::merge(entries, entries + entry_count, new_entries.begin(), new_entries.end(), own_entries.begin(),
+                   [](const IndexEntry& a, const IndexEntry& b) { return a.key < b.key; });
+    }
+    if (index_map.data) munmap(index_map.data, index_map.size);
+    index_map = Mapping();
+
+    if (!written) {
+        game_count = own_offsets.size();
+        entry_count = own_entries.size();
+        offsets = own_offsets.data();
+        entries = own_entries.data();
+        return true;
+    }
+    game_count = entry_count = 0;
+    offsets = nullptr;
+    entries = nullptr;
+    return update_index(index_path);
+}
+
+GameRecord GameDB::game(size_t i) const {
+    GameRecord g;
+    size_t next;
+    if (i < game_count) parse_game(static_cast<const uint8_t*>(games_map.data), games_map.size, offsets[i], g, next);
+    return g;
+}
+
+std::vector<PositionRef> GameDB::find(uint64_t key) const {
+    auto range = std::equal_range(entries, entries + entry_count, IndexEntry{key, 0, 0},
+                                  [](const IndexEntry& a, const IndexEntry& b) { return a.key < b.key; });
+    std::vector<PositionRef> found;
+    for (auto it = range.first; it != range.second; ++it) found.push_back({it->game, it->ply});
+    return found;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GomokuAI.hpp"
+
+// One finished (or abandoned) game. Colors are absolute: the first player's
+// stones are player 1, the second player's player 2.
+struct GameRecord {
+    int board_size = 20;
+    int8_t result = 0;           // 1 or 2: winner, 0: draw or unfinished
+    uint64_t timestamp = 0;      // unix seconds
+    std::string first, second;   // player names, at most 255 bytes each
+    std::vector<uint16_t> moves; // cell index y * board_size + x, first player first
+};
+
+// Append-only game file:
+//   char[4] "GGDB", u32 version
+//   then per game: u32 record_bytes (excluding this field), u16 board_size,
+//   i8 result, u8 reserved, u64 timestamp, u8 first_len, u8 second_len,
+//   names, u16 move_count, u16 moves[move_count]   (all little endian)
+// Each game is written with a single fwrite and flushed, so a crash can at
+// worst leave a truncated last record, which readers ignore.
+class GameWriter {
+public:
+    ~GameWriter();
+    bool open(const std::string& path); // appends, creating the file if needed
+    bool append(const GameRecord& game);
+    bool close();
+    bool is_open() const { return file != nullptr; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> buf;
+};
+
+// Position after `ply` moves of game number `game`
+struct PositionRef {
+    uint32_t game;
+    uint32_t ply;
+};
+
+// Read-only view of a game file, mmapped, with a Zobrist index of every
+// position kept next to it in <path>.idx:
+//   char[4] "GGDX", u32 version, u64 indexed_bytes, u64 game_count, u64 entry_count,
+//   u64 offsets[game_count], then {u64 key, u32 game, u32 ply}[entry_count] sorted by key
+// open() extends a stale index with the games appended since it was written.
+class GameDB {
+public:
+    ~GameDB();
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return game_count; }
+    GameRecord game(size_t i) const;
+    std::vector<PositionRef> find(uint64_t key) const;
+
+    // Index key of ai's position: ai must hold the stones with absolute colors.
+    // Keys are xors of stone_key() and differ between board sizes.
+    static uint64_t position_key(const GomokuAI& ai);
+    static uint64_t stone_key(int board_size, int idx, int player);
+
+    struct IndexEntry {
+        uint64_t key;
+        uint32_t game;
+        uint32_t ply;
+    };
+
+private:
+    struct Mapping {
+        void* data = nullptr;
+        size_t size = 0;
+    };
+    Mapping games_map, index_map;
+
+    size_t game_count = 0;
+    size_t entry_count = 0;
+    const uint64_t* offsets = nullptr;
+    const IndexEntry* entries = nullptr;
+    // Used instead of the index file when it cannot be written
+    std::vector<uint64_t> own_offsets;
+    std::vector<IndexEntry> own_entries;
+
+    bool update_index(const std::string& index_path);
+};
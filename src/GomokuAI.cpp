@@ -1,4 +1,7 @@
 #include "GomokuAI.hpp"
+#include "MCTS.hpp"
+#include "ProvenResults.hpp"
+#include "Search.hpp"
 #include <algorithm>
 #include <chrono>
 #include <iostream>
@@ -6,50 +9,194 @@
 #include <limits>
 #include <array>
 #include <cstring>
+#include <charconv>
 #include <cmath>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <sys/mman.h>
 
 // --- CONSTANTS & CONFIG ---
-constexpr int INF = 1000000000;
-constexpr int SCORE_WIN = 100000000;
-constexpr int TIMEOUT_SCORE = -2000000000; // Sentinel value
 constexpr int TIME_CHECK_STRIDE = 4096;    // Check time every N nodes
 
-struct TTEntry {
-    uint64_t key;
-    int depth;
+struct TTData {
+    int depth; // in ONE_PLY units
     int value;
     int flag; // 0: Exact, 1: Lowerbound, 2: Upperbound
     int best_move_idx;
 };
 
-constexpr int TT_SIZE = 1 << 20;
-TTEntry TT[TT_SIZE];
+// Shared between search threads without locks: `check` stores key ^ data, so
+// an entry torn by two concurrent writers reads back as a miss.
+struct TTEntry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
 
-int killer_moves[100][2];
-int history_moves[3][400]; // [player][idx]
+// Both tables are power-of-two sized from the memory budget (see size_tables)
+// and live in anonymous mappings; zero-filled pages are valid empty entries.
+constexpr size_t DEFAULT_TT_ENTRIES = 1 << 20;
+constexpr size_t MIN_TT_ENTRIES = 1 << 12;
+constexpr size_t MAX_TT_ENTRIES = size_t(1) << 28;
+TTEntry* TT = nullptr;
+size_t tt_mask = 0;
+
+// Static evaluations, direct-mapped. Each slot packs the upper 32 bits of the
+// key with the score so it is written in a single atomic store.
+constexpr size_t DEFAULT_EVAL_CACHE_ENTRIES = 1 << 18;
+constexpr uint64_t EVAL_SIDE_KEY = 0x9d39247e33776d41ULL; // xored in when player 2 is to move
+std::atomic<uint64_t>* eval_cache = nullptr;
+size_t eval_cache_mask = 0;
+
+// 0: default table sizes; otherwise the whole engine should fit in this many bytes
+size_t memory_limit = 0;
+// Code, libraries, protocol buffers and thread stacks in use, not counted per
+// structure: the brain's measured resident size with the smallest tables
+constexpr size_t RUNTIME_RESERVE = 3584 << 10;
+// MCTS tree arena: a quarter of memory_limit, or this without one
+constexpr size_t MCTS_DEFAULT_ARENA = 256 << 20;
+constexpr uint64_t MCTS_PLAYOUTS_PER_DEPTH = 1000;
+// Table changes logged per make_move(): about 65 on average, rarely over 80
+constexpr size_t UNDO_CHANGES_PER_MOVE = 96;
+
+static size_t mcts_arena_bytes() {
+    return memory_limit > 0 ? memory_limit / 4 : MCTS_DEFAULT_ARENA;
+}
 
 std::chrono::steady_clock::time_point start_time;
-int time_limit_ms;
 int guard_time_ms;
-bool time_out_flag;
-uint64_t nodes_visited;
+uint64_t node_limit;
+std::atomic<uint64_t> shared_nodes;
+std::atomic<bool> time_out_flag;
+std::atomic<bool> stop_requested; // set from another thread by stop_search()
+std::atomic<int> best_so_far{-1};  // cell index, read from another thread by best_move_so_far()
+thread_local uint64_t nodes_visited; // not yet added to shared_nodes
 
 // --- HELPERS ---
 
+// Entries are tagged with the generation that stored them, so clearing the
+// table is a counter bump; the memory is only zeroed when the 7-bit counter wraps.
+constexpr int TT_GENERATION_SHIFT = 57;
+constexpr uint64_t TT_GENERATIONS = 128;
+uint64_t tt_generation = 1; // 0 marks never-written (zeroed) entries
+
 void clear_tt() {
-    std::memset(TT, 0, sizeof(TT));
+    if (++tt_generation < TT_GENERATIONS) return;
+    tt_generation = 1;
+    for (size_t i = 0; i <= tt_mask; ++i) {
+        TT[i].check.store(0, std::memory_order_relaxed);
+        TT[i].data.store(0, std::memory_order_relaxed);
+    }
 }
 
-void clear_history() {
-    std::memset(killer_moves, -1, sizeof(killer_moves));
-    std::memset(history_moves, 0, sizeof(history_moves));
+static uint64_t tt_pack(const TTData& d) {
+    return static_cast<uint32_t>(d.value)
+         | static_cast<uint64_t>(std::min(d.depth, 0xFF)) << 32
+         | static_cast<uint64_t>(d.flag & 0x3) << 40
+         | static_cast<uint64_t>(d.best_move_idx + 1) << 42
+         | tt_generation << TT_GENERATION_SHIFT;
+}
+
+bool tt_probe(uint64_t key, TTData& out) {
+    const TTEntry& e = TT[key & tt_mask];
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    if ((e.check.load(std::memory_order_relaxed) ^ data) != key || (data >> TT_GENERATION_SHIFT) != tt_generation) {
+        return false;
+    }
+    out.value = static_cast<int32_t>(static_cast<uint32_t>(data));
+    out.depth = static_cast<int>((data >> 32) & 0xFF);
+    out.flag = static_cast<int>((data >> 40) & 0x3);
+    out.best_move_idx = static_cast<int>((data >> 42) & 0x7FFF) - 1;
+    return true;
+}
+
+void tt_store(uint64_t key, const TTData& d) {
+    TTEntry& e = TT[key & tt_mask];
+    uint64_t data = tt_pack(d);
+    e.check.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+// Xored into every eval cache key; a new salt makes all cached entries miss
+uint64_t eval_cache_salt = 0;
+
+void clear_eval_cache() {
+    eval_cache_salt = (eval_cache_salt + 0x9e3779b97f4a7c15ULL) * 0xbf58476d1ce4e5b9ULL;
+}
+
+// --- TABLE MEMORY ---
+
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+// Zeroed anonymous memory, on huge pages when the system has them: explicit
+// hugetlbfs pages first, otherwise transparent huge pages if enabled
+static void* map_table(size_t bytes) {
+    void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (bytes % HUGE_PAGE_SIZE == 0) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+        if (bytes >= HUGE_PAGE_SIZE) madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    }
+    return p;
+}
+
+// Returns false when the table already had that size (and kept its contents)
+template <typename T>
+static bool resize_table(T*& table, size_t& mask, size_t entries) {
+    if (table && mask + 1 == entries) return false;
+    if (table) munmap(table, (mask + 1) * sizeof(T));
+    // Halve until the mapping succeeds
+    for (table = nullptr; !table && entries > 1; entries /= 2) {
+        table = static_cast<T*>(map_table(entries * sizeof(T)));
+        mask = entries - 1;
+    }
+    return true;
+}
+
+static size_t floor_pow2(size_t n) {
+    size_t p = 1;
+    while (p * 2 <= n) p *= 2;
+    return p;
+}
+
+// Sizes the TT and eval cache for memory_limit: what is left of the budget
+// after the other structures goes 7/8 to the TT and 1/8 to the eval cache.
+// With `clear`, a table that keeps its size is emptied (new ones already are).
+static void size_tables(size_t other_bytes, bool clear) {
+    size_t tt_entries = DEFAULT_TT_ENTRIES;
+    size_t eval_entries = DEFAULT_EVAL_CACHE_ENTRIES;
+    if (memory_limit > 0) {
+        size_t used = other_bytes + RUNTIME_RESERVE;
+        size_t tables = memory_limit > used ? memory_limit - used : 0;
+        tt_entries = std::clamp(floor_pow2(tables / 8 * 7 / sizeof(TTEntry)), MIN_TT_ENTRIES, MAX_TT_ENTRIES);
+        eval_entries = std::clamp(floor_pow2(tables / 8 / sizeof(uint64_t)), size_t(1) << 10, tt_entries);
+    }
+    if (!resize_table(TT, tt_mask, tt_entries) && clear) clear_tt();
+    if (!resize_table(eval_cache, eval_cache_mask, eval_entries) && clear) clear_eval_cache();
+}
+
+void flush_nodes() {
+    shared_nodes.fetch_add(nodes_visited, std::memory_order_relaxed);
+    nodes_visited = 0;
 }
 
+// The node limit applies to the sum over all threads; the others' counts
+// arrive every TIME_CHECK_STRIDE nodes, so a parallel search may overshoot
+// it by that much per thread
 bool check_time() {
-    ++nodes_visited;
-    if ((nodes_visited & (TIME_CHECK_STRIDE - 1)) != 0) {
+    if (++nodes_visited + shared_nodes.load(std::memory_order_relaxed) >= node_limit) time_out_flag = true;
+    if (nodes_visited < TIME_CHECK_STRIDE) {
         return time_out_flag;
     }
+    flush_nodes();
     if (time_out_flag) return true;
 
     auto now = std::chrono::steady_clock::now();
@@ -63,45 +210,220 @@ bool check_time() {
 
 // --- ZOBRIST ---
 
-static uint64_t splitmix64(uint64_t& x) {
-    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+constexpr uint64_t ZOBRIST_SEED = 0x123456789ABCDEFULL;
+constexpr uint64_t SPLITMIX_STEP = 0x9e3779b97f4a7c15ULL;
+
+// Output n (from 1) of a splitmix64 stream, computed directly: the counter
+// of the generator is seed + n * step
+static uint64_t splitmix64_at(uint64_t seed, uint64_t n) {
+    uint64_t z = seed + n * SPLITMIX_STEP;
     z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
     z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
     return z ^ (z >> 31);
 }
 
-void GomokuAI::init_zobrist() {
-    zobrist.resize(width * height * 3);
-    uint64_t seed = 0x123456789ABCDEFULL;
-    for (auto& z : zobrist) z = splitmix64(seed);
-}
-
-inline uint64_t GomokuAI::zobrist_at(int idx, int player) const {
-    return zobrist[idx * 3 + player];
+// Derived from the cell index on demand, so no table grows with the board;
+// the keys are those of the stream the table used to be filled from
+uint64_t GomokuAI::zobrist_at(int idx, int player) const {
+    return splitmix64_at(ZOBRIST_SEED, static_cast<uint64_t>(idx) * 3 + player + 1);
 }
 
 // --- GOMOKU CLASS ---
 
-GomokuAI::GomokuAI() : width(20), height(20), min_x(10), max_x(10), min_y(10), max_y(10) {}
+GomokuAI::GomokuAI() : width(20), height(20), min_x(10), max_x(10), min_y(10), max_y(10) {
+    clear_history();
+}
 
 void GomokuAI::init(int size) {
     width = size;
     height = size;
     board.assign(width * height, 0);
+    neighbors.assign(width * height, 0);
+    runs.assign(width * height * 8, 0);
+    windows.assign(width * height * 4, 0);
+    threat_refs.assign(width * height * 4, 0);
+    for (CellSet& set : threat_sets) set.reset(width * height);
+    stone_set.reset(width * height);
+    candidate_set.reset(width * height);
+    undo_stack.clear();
+    undo_changes.clear();
 
     min_x = size; max_x = 0;
     min_y = size; max_y = 0;
 
-    init_zobrist();
+    nnue = active_nnue(width, height);
+    accumulator.assign(nnue ? 2 * nnue->hidden : 0, 0);
+    if (nnue) nnue->refresh(board, accumulator.data());
+
     hash_key = 0;
-    clear_tt();
+    undo_stack.reserve(width * height);
+    undo_changes.reserve(static_cast<size_t>(max_depth + 8) * UNDO_CHANGES_PER_MOVE);
+    MemoryUsage m = memory_usage();
+    size_tables(m.total() - m.tt - m.eval_cache, true);
     clear_history();
 }
 
-Point GomokuAI::parse_coordinates(const std::string& s) {
+void GomokuAI::clear_history() {
+    std::memset(killer_moves, -1, sizeof(killer_moves));
+    history_moves.assign(2 * static_cast<size_t>(width) * height, 0);
+}
+
+void GomokuAI::set_memory_limit(size_t bytes) {
+    memory_limit = bytes;
+    MemoryUsage m = memory_usage();
+    size_tables(m.total() - m.tt - m.eval_cache, false);
+}
+
+// The MCTS arena comes out of the memory budget, so the tables are resized
+void GomokuAI::set_backend(SearchBackend b) {
+    backend = b;
+    if (memory_limit > 0) set_memory_limit(memory_limit);
+}
+
+MemoryUsage GomokuAI::memory_usage() const {
+    size_t cells = static_cast<size_t>(width) * height;
+    size_t threads = static_cast<size_t>(num_threads);
+    MemoryUsage m;
+    m.tt = (tt_mask + 1) * sizeof(TTEntry);
+    m.eval_cache = (eval_cache_mask + 1) * sizeof(uint64_t);
+    m.history = threads * (sizeof(killer_moves) + 2 * cells * sizeof(int));
+    // Per search thread: a board copy with its undo stack, and one sorted move list per ply
+    size_t board_bytes = cells * (sizeof(int) + 17 * sizeof(uint8_t) + sizeof(UndoEntry) +
+                                  12 * sizeof(int));
+    size_t move_lists = static_cast<size_t>(max_depth + 8) * cells * sizeof(std::pair<int, int>);
+    size_t undo_log = static_cast<size_t>(max_depth + 8) * UNDO_CHANGES_PER_MOVE * sizeof(UndoChange);
+    m.search = threads * (board_bytes + move_lists + undo_log);
+    m.mcts = backend == SearchBackend::MCTS ? std::max(mcts_arena_bytes(), mcts_memory()) : mcts_memory();
+    m.nnue = accumulator.size() * sizeof(int16_t) * (threads + 1);
+    if (nnue) {
+        m.nnue += nnue->ft_bias.size() * sizeof(int16_t) + nnue->ft_weights.size() * sizeof(int16_t) +
+                  nnue->out_weights.size();
+    }
+    return m;
+}
+
+Point GomokuAI::parse_coordinates(std::string_view s) {
     size_t c = s.find(',');
-    if (c == std::string::npos) return {-1, -1};
-    return {std::stoi(s.substr(0, c)), std::stoi(s.substr(c + 1))};
+    if (c == std::string_view::npos) return {-1, -1};
+    Point p;
+    auto rx = std::from_chars(s.data(), s.data() + c, p.x);
+    auto ry = std::from_chars(s.data() + c + 1, s.data() + s.size(), p.y);
+    if (rx.ec != std::errc() || ry.ec != std::errc()) return {-1, -1};
+    return p;
+}
+
+void GomokuAI::add_neighbors(int idx, int delta) {
+    int x = idx % width;
+    int y = idx / width;
+    int sx = std::max(0, x - 2), ex = std::min(width - 1, x + 2);
+    int sy = std::max(0, y - 2), ey = std::min(height - 1, y + 2);
+    for (int ny = sy; ny <= ey; ++ny)
+        for (int nx = sx; nx <= ex; ++nx) {
+            log_byte(UndoChange::NEIGHBORS, ny * width + nx, neighbors[ny * width + nx]);
+            neighbors[ny * width + nx] += delta;
+            refresh_candidate(ny * width + nx);
+        }
+}
+
+void GomokuAI::refresh_candidate(int idx) {
+    bool candidate = board[idx] == 0 && neighbors[idx] != 0;
+    if (candidate != candidate_set.contains(idx)) {
+        if (candidate) set_insert(UndoChange::CANDIDATES, candidate_set, idx);
+        else set_erase(UndoChange::CANDIDATES, candidate_set, idx);
+    }
+}
+
+// Recomputes the runs of the cells whose 4-cell window in some direction
+// contains idx, walking outwards from idx so each cell extends its neighbor's
+// run; a walk stops at the first cell whose run did not change.
+void GomokuAI::update_runs(int idx) {
+    static const int dx[] = {1, 0, 1, -1};
+    static const int dy[] = {0, 1, 1, 1};
+    int x = idx % width;
+    int y = idx / width;
+    for (int k = 0; k < 4; ++k) {
+        for (int side = 0; side < 2; ++side) {
+            // side 0: cells before idx, whose forward run (low nibble) reaches idx
+            int sx = side == 0 ? -dx[k] : dx[k];
+            int sy = side == 0 ? -dy[k] : dy[k];
+            int shift = side == 0 ? 0 : 4;
+            for (int p = 1; p <= 2; ++p) {
+                int prev = idx;
+                for (int i = 1; i <= 4; ++i) {
+                    int nx = x + i * sx, ny = y + i * sy;
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= height) break;
+                    int c = ny * width + nx;
+                    int run = 0;
+                    if (board[prev] == p) run = std::min(4, 1 + ((runs[(prev * 4 + k) * 2 + p - 1] >> shift) & 0xF));
+                    uint8_t& r = runs[(c * 4 + k) * 2 + p - 1];
+                    uint8_t updated = static_cast<uint8_t>((r & (0xF0 >> shift)) | run << shift);
+                    if (updated == r) break;
+                    log_byte(UndoChange::RUNS, (c * 4 + k) * 2 + p - 1, r);
+                    r = updated;
+                    prev = c;
+                }
+            }
+        }
+    }
+}
+
+// Adds (delta 1) or removes (delta -1) what the window contributes to the
+// threat registry with the current board and counts
+void GomokuAI::window_threats(int window, int delta) {
+    static const int step_x[] = {1, 0, 1, -1};
+    static const int step_y[] = {0, 1, 1, 1};
+    int n1 = windows[window] & 0xF;
+    int n2 = windows[window] >> 4;
+    int n = n2 == 0 ? n1 : (n1 == 0 ? n2 : 0);
+    if (n < 3 || n > 4) return; // mixed, too few stones, or already five
+    int player = n2 == 0 ? 1 : 2;
+    int slot = (player - 1) * 2 + (n == 4 ? 0 : 1);
+
+    int k = window % 4;
+    int x = (window / 4) % width;
+    int y = (window / 4) / width;
+    for (int i = 0; i < 5; ++i) {
+        int c = (y + i * step_y[k]) * width + x + i * step_x[k];
+        if (board[c] != 0) continue;
+        uint8_t& refs = threat_refs[c * 4 + slot];
+        log_byte(UndoChange::THREAT_REFS, c * 4 + slot, refs);
+        uint8_t table = static_cast<uint8_t>(UndoChange::THREATS + slot);
+        if (delta > 0 && refs++ == 0) set_insert(table, threat_sets[slot], c);
+        if (delta < 0 && --refs == 0) set_erase(table, threat_sets[slot], c);
+    }
+}
+
+// Writes board[idx] and moves its stone in the counts of the (up to 20)
+// windows through idx, refreshing their threats
+void GomokuAI::set_stone(int idx, int player) {
+    static const int dx[] = {1, 0, 1, -1};
+    static const int dy[] = {0, 1, 1, 1};
+    int x = idx % width;
+    int y = idx / width;
+    int through[20];
+    int count = 0;
+    for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 5; ++j) {
+            int sx = x - j * dx[k], sy = y - j * dy[k];
+            int ex = sx + 4 * dx[k], ey = sy + 4 * dy[k];
+            if (sx < 0 || sx >= width || sy < 0 || sy >= height || ex < 0 || ex >= width || ey >= height) continue;
+            through[count++] = (sy * width + sx) * 4 + k;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) window_threats(through[i], -1);
+    int old = board[idx];
+    board[idx] = player;
+    if (old == 0 && player != 0) set_insert(UndoChange::STONES, stone_set, idx);
+    if (old != 0 && player == 0) set_erase(UndoChange::STONES, stone_set, idx);
+    refresh_candidate(idx);
+    for (int i = 0; i < count; ++i) {
+        int w = through[i];
+        log_byte(UndoChange::WINDOWS, w, windows[w]);
+        if (old != 0) windows[w] = static_cast<uint8_t>(windows[w] - (old == 1 ? 0x01 : 0x10));
+        if (player != 0) windows[w] = static_cast<uint8_t>(windows[w] + (player == 1 ? 0x01 : 0x10));
+        window_threats(w, 1);
+    }
 }
 
 void GomokuAI::update_board(int x, int y, int player) {
@@ -110,7 +432,12 @@ void GomokuAI::update_board(int x, int y, int player) {
 
     if (board[idx] != player) {
         if (board[idx] != 0) hash_key ^= zobrist_at(idx, board[idx]);
-        board[idx] = player;
+        if (board[idx] == 0) add_neighbors(idx, 1);
+        else if (player == 0) add_neighbors(idx, -1);
+        if (nnue && board[idx] != 0) nnue->remove_stone(accumulator.data(), idx, board[idx]);
+        if (nnue && player != 0) nnue->add_stone(accumulator.data(), idx, player);
+        set_stone(idx, player);
+        update_runs(idx);
         if (player != 0) {
             hash_key ^= zobrist_at(idx, player);
             // Dynamic bounds update
@@ -122,6 +449,108 @@ void GomokuAI::update_board(int x, int y, int player) {
     }
 }
 
+int GomokuAI::sync_board(const std::vector<int>& target) {
+    if (board.size() != static_cast<size_t>(width * height)) init(width);
+    if (target.size() != board.size()) return -1;
+    undo_stack.clear();
+    undo_changes.clear();
+
+    int changed = 0;
+    bool removed = false;
+    for (int idx = 0; idx < width * height; ++idx) {
+        if (board[idx] == target[idx]) continue;
+        removed = removed || board[idx] != 0;
+        update_board(idx % width, idx / width, target[idx]);
+        ++changed;
+    }
+
+    // update_board only grows the bounds
+    if (removed) {
+        min_x = width; max_x = 0;
+        min_y = height; max_y = 0;
+        for (int idx : stone_set) {
+            min_x = std::min(min_x, idx % width); max_x = std::max(max_x, idx % width);
+            min_y = std::min(min_y, idx / width); max_y = std::max(max_y, idx / width);
+        }
+    }
+    return changed;
+}
+
+void GomokuAI::make_move(int idx, int player) {
+    undo_stack.push_back({idx, hash_key, min_x, max_x, min_y, max_y, undo_changes.size()});
+    int x = idx % width;
+    int y = idx / width;
+
+    journaling = true;
+    set_stone(idx, player);
+    add_neighbors(idx, 1);
+    update_runs(idx);
+    journaling = false;
+    hash_key ^= zobrist_at(idx, player);
+    if (nnue) nnue->add_stone(accumulator.data(), idx, player);
+    if (x < min_x) min_x = x;
+    if (x > max_x) max_x = x;
+    if (y < min_y) min_y = y;
+    if (y > max_y) max_y = y;
+}
+
+// Restores the logged table bytes and set entries newest first, so every
+// set gets back its exact list order; nothing is recomputed
+void GomokuAI::unmake_move() {
+    const UndoEntry& u = undo_stack.back();
+    if (nnue) nnue->remove_stone(accumulator.data(), u.idx, board[u.idx]);
+    board[u.idx] = 0;
+    for (size_t i = undo_changes.size(); i-- > u.first_change;) {
+        const UndoChange& c = undo_changes[i];
+        switch (c.table) {
+        case UndoChange::NEIGHBORS: neighbors[c.at] = c.old; break;
+        case UndoChange::RUNS: runs[c.at] = c.old; break;
+        case UndoChange::WINDOWS: windows[c.at] = c.old; break;
+        case UndoChange::THREAT_REFS: threat_refs[c.at] = c.old; break;
+        default: {
+            CellSet& set = c.table == UndoChange::STONES       ? stone_set
+                         : c.table == UndoChange::CANDIDATES ? candidate_set
+                                                             : threat_sets[c.table - UndoChange::THREATS];
+            if (c.old) set.restore(c.at, c.pos);
+            else set.erase(c.at);
+        }
+        }
+    }
+    undo_changes.resize(u.first_change);
+    hash_key = u.hash_key;
+    min_x = u.min_x; max_x = u.max_x;
+    min_y = u.min_y; max_y = u.max_y;
+    undo_stack.pop_back();
+}
+
+void GomokuAI::stop_search() {
+    stop_requested = true;
+    time_out_flag = true;
+}
+
+void GomokuAI::clear_stop() {
+    stop_requested = false;
+    best_so_far = -1;
+}
+
+Point GomokuAI::best_move_so_far() const {
+    int idx = best_so_far.load();
+    if (idx < 0) return {-1, -1};
+    return {idx % width, idx / width};
+}
+
+int GomokuAI::static_eval(int player) const {
+    return eval_state(*this, player);
+}
+
+int GomokuAI::tactical_move_score(int idx, int player) const {
+    return tactical_score(*this, idx, player);
+}
+
+bool GomokuAI::is_five(int idx) const {
+    return board[idx] != 0 && check_win(board, idx, width, height, board[idx]);
+}
+
 // --- EVALUATION & CHECKS ---
 
 bool check_win(const std::vector<int>& board, int idx, int w, int h, int player) {
@@ -153,19 +582,11 @@ bool check_win(const std::vector<int>& board, int idx, int w, int h, int player)
 
 int eval_state(const GomokuAI& ai, int player) {
     // Simplified Evaluation Function
-    const int W_LIVE_4 = 1000000; // Win Guaranteed
-    const int W_DEAD_4 = 15000;   // Win next turn if not blocked (Check)
-    const int W_LIVE_3 = 8000;    // Create W_LIVE_4 next turn (Checkmate threat)
-    const int W_DEAD_3 = 500;
-    const int W_LIVE_2 = 100;
-
-    int total_score = 0;
-    // Iterate over the whole board to avoid missing lines starting outside dynamic bounds
-    // Optimization: we could iterate min_x-4 to max_x+4 but 20x20 is small enough.
-    int sx = 0; int ex = ai.width - 1;
-    int sy = 0; int ey = ai.height - 1;
-
-    auto eval_line = [&](int cx, int cy, int dx, int dy) -> int {
+    const EvalParams& w = ai.params;
+
+    int64_t total_score = 0;
+
+    auto eval_line = [&](int cx, int cy, int dx, int dy) -> int64_t {
         int idx = cy * ai.width + cx;
         int p = ai.board[idx];
         if (p == 0) return 0;
@@ -185,129 +606,122 @@ int eval_state(const GomokuAI& ai, int player) {
 
         int val = 0;
         if (count >= 5) val = SCORE_WIN;
-        else if (count == 4) val = (open_head && open_tail) ? W_LIVE_4 : (open_head || open_tail ? W_DEAD_4 : 0);
-        else if (count == 3) val = (open_head && open_tail) ? W_LIVE_3 : (open_head || open_tail ? W_DEAD_3 : 0);
-        else if (count == 2 && open_head && open_tail) val = W_LIVE_2;
+        else if (count == 4) val = (open_head && open_tail) ? w.live_4 : (open_head || open_tail ? w.dead_4 : 0);
+        else if (count == 3) val = (open_head && open_tail) ? w.live_3 : (open_head || open_tail ? w.dead_3 : 0);
+        else if (count == 2 && open_head && open_tail) val = w.live_2;
 
         // Bias: Slight attack bias to maintain initiative, but rely on weights for safety
-        if (p == player) return static_cast<int>(val * 1.1); // 10% Attack bonus
+        if (p == player) return static_cast<int64_t>(val) * w.attack_bias / 100;
         return -val; // No massive defense bias anymore
     };
 
-    for (int y = sy; y <= ey; ++y) {
-        for (int x = sx; x <= ex; ++x) {
-            total_score += eval_line(x, y, 1, 0);
-            total_score += eval_line(x, y, 0, 1);
-            total_score += eval_line(x, y, 1, 1);
-            total_score += eval_line(x, y, -1, 1);
-        }
+    // Lines start at a stone, so only the stones need visiting
+    for (int idx : ai.stones()) {
+        int x = idx % ai.width;
+        int y = idx / ai.width;
+        total_score += eval_line(x, y, 1, 0);
+        total_score += eval_line(x, y, 0, 1);
+        total_score += eval_line(x, y, 1, 1);
+        total_score += eval_line(x, y, -1, 1);
     }
-    return total_score;
+    return static_cast<int>(std::clamp<int64_t>(total_score, -MAX_EVAL, MAX_EVAL));
+}
+
+// Static evaluation with the backend active for this board
+int evaluate(const GomokuAI& ai, int player) {
+    if (ai.nnue) return std::clamp(ai.nnue->evaluate(ai.accumulator.data(), player), -MAX_EVAL, MAX_EVAL);
+    return eval_state(ai, player);
+}
+
+// evaluate() through the eval cache
+int cached_eval(const GomokuAI& ai, int player) {
+    uint64_t key = ai.get_hash_key() ^ eval_cache_salt ^ (player == 2 ? EVAL_SIDE_KEY : 0);
+    uint64_t tag = key >> 32;
+    std::atomic<uint64_t>& slot = eval_cache[key & eval_cache_mask];
+
+    uint64_t e = slot.load(std::memory_order_relaxed);
+    if (tag != 0 && (e >> 32) == tag) return static_cast<int32_t>(static_cast<uint32_t>(e));
+
+    int score = evaluate(ai, player);
+    slot.store(tag << 32 | static_cast<uint32_t>(score), std::memory_order_relaxed);
+    return score;
 }
 
 // --- MOVE ORDERING ---
 
-// Scores a single move for sorting. Higher is better.
-int score_move(const GomokuAI& ai, int idx, int player, int ply) {
+// Centrality and immediate threats of playing idx; the part of score_move that
+// only depends on the board.
+int tactical_score(const GomokuAI& ai, int idx, int player) {
+    const EvalParams& w = ai.params;
     int score = 0;
-    
-    // 0. Killer Move Bonus
-    if (killer_moves[ply][0] == idx) score += 50000;
-    else if (killer_moves[ply][1] == idx) score += 40000;
-
-    // 1. History Heuristic
-    score += history_moves[player][idx];
 
     // 2. Centrality (Tie-breaker)
     int x = idx % ai.width;
     int y = idx / ai.width;
     int dist = std::abs(x - ai.width/2) + std::abs(y - ai.height/2);
-    score -= dist * 10;
+    score -= dist * w.move_center;
 
     // 3. Tactical Analysis (Immediate Threats)
     // "What if I play here?" vs "What if Opponent plays here?"
     
-    int dx[] = {1, 0, 1, -1};
-    int dy[] = {0, 1, 1, 1};
     int opp = (player == 1) ? 2 : 1;
 
     for (int k = 0; k < 4; ++k) {
-        // My potential patterns (Attack)
-        int my_count = 1;
-        for (int i = 1; i < 5; ++i) {
-            int nx = x + i * dx[k], ny = y + i * dy[k];
-            if (nx < 0 || nx >= ai.width || ny < 0 || ny >= ai.height || ai.board[ny * ai.width + nx] != player) break;
-            my_count++;
-        }
-        for (int i = 1; i < 5; ++i) {
-            int nx = x - i * dx[k], ny = y - i * dy[k];
-            if (nx < 0 || nx >= ai.width || ny < 0 || ny >= ai.height || ai.board[ny * ai.width + nx] != player) break;
-            my_count++;
-        }
-
-        // Opponent potential patterns (Defense/Block)
-        int opp_count = 1;
-        for (int i = 1; i < 5; ++i) {
-            int nx = x + i * dx[k], ny = y + i * dy[k];
-            if (nx < 0 || nx >= ai.width || ny < 0 || ny >= ai.height || ai.board[ny * ai.width + nx] != opp) break;
-            opp_count++;
-        }
-        for (int i = 1; i < 5; ++i) {
-            int nx = x - i * dx[k], ny = y - i * dy[k];
-            if (nx < 0 || nx >= ai.width || ny < 0 || ny >= ai.height || ai.board[ny * ai.width + nx] != opp) break;
-            opp_count++;
-        }
+        // Line through idx if I (attack) or the opponent (block) played there
+        int my_count = 1 + ai.run_length(idx, k, player);
+        int opp_count = 1 + ai.run_length(idx, k, opp);
 
         // Weighting: Win > Block Win > Block 4 > Create 4 > Create 3 > Block 3
-        if (my_count >= 5) score += 100000000;      // WIN NOW
-        else if (opp_count >= 5) score += 90000000; // BLOCK WIN (Must do)
-        else if (opp_count == 4) score += 2000000;  // Block 4 (Critical Defense)
-        else if (my_count == 4) score += 1000000;   // Create 4 (Aggressive)
-        else if (my_count == 3) score += 20000;     // Create 3
-        else if (opp_count == 3) score += 15000;    // Block 3
+        if (my_count >= 5) score += w.move_win;             // WIN NOW
+        else if (opp_count >= 5) score += w.move_block_win; // BLOCK WIN (Must do)
+        else if (opp_count == 4) score += w.move_block_4;   // Block 4 (Critical Defense)
+        else if (my_count == 4) score += w.move_make_4;     // Create 4 (Aggressive)
+        else if (my_count == 3) score += w.move_make_3;     // Create 3
+        else if (opp_count == 3) score += w.move_block_3;   // Block 3
     }
 
     return score;
 }
 
-// Generates and sorts moves based on proximity to existing stones and heuristics
-std::vector<std::pair<int, int>> get_sorted_moves(const GomokuAI& ai, int player, int ply, int best_tt_move = -1) {
+// Scores a single move for sorting. Higher is better.
+int score_move(const GomokuAI& ai, int idx, int player, int ply) {
+    int score = 0;
+    
+    // 0. Killer Move Bonus
+    if (ply < GomokuAI::MAX_KILLER_PLY) {
+        if (ai.killer_moves[ply][0] == idx) score += 50000;
+        else if (ai.killer_moves[ply][1] == idx) score += 40000;
+    }
+
+    // 1. History Heuristic
+    score += ai.history_moves[(player - 1) * ai.width * ai.height + idx];
+
+    return score + tactical_score(ai, idx, player);
+}
+
+// Generates and sorts moves based on proximity to existing stones and heuristics.
+// A non-empty `only` replaces the candidates with those cells.
+std::vector<std::pair<int, int>> get_sorted_moves(const GomokuAI& ai, int player, int ply, int best_tt_move,
+                                                  const std::vector<int>& only) {
     std::vector<std::pair<int, int>> moves;
     moves.reserve(64);
 
-    int sx = std::max(0, ai.min_x - 2);
-    int ex = std::min(ai.width - 1, ai.max_x + 2);
-    int sy = std::max(0, ai.min_y - 2);
-    int ey = std::min(ai.height - 1, ai.max_y + 2);
-    int w = ai.width;
-
-    for (int y = sy; y <= ey; ++y) {
-        for (int x = sx; x <= ex; ++x) {
-            int idx = y * w + x;
-            if (ai.board[idx] != 0) continue;
-
-            // Only consider moves within 2 distance of an existing stone
-            bool neighbor_found = false;
-            for (int dy = -2; dy <= 2; ++dy) {
-                for (int dx = -2; dx <= 2; ++dx) {
-                    if (dx == 0 && dy == 0) continue;
-                    int nx = x + dx, ny = y + dy;
-                    if (nx >= 0 && nx < w && ny >= 0 && ny < ai.height) {
-                        if (ai.board[ny * w + nx] != 0) {
-                            neighbor_found = true;
-                            break;
-                        }
-                    }
-                }
-                if (neighbor_found) break;
-            }
-
-            if (neighbor_found) {
-                int score = score_move(ai, idx, player, ply);
-                if (idx == best_tt_move) score += 200000000; // PV move receives massive bonus
-                moves.push_back({score, idx});
-            }
+    if (!only.empty()) {
+        for (int idx : only) {
+            int score = score_move(ai, idx, player, ply);
+            if (idx == best_tt_move) score += 200000000;
+            moves.push_back({score, idx});
         }
+        std::sort(moves.rbegin(), moves.rend());
+        return moves;
+    }
+
+    // Candidates are the empty cells within 2 of a stone; their order does not
+    // matter since (score, idx) pairs are sorted in full
+    for (int idx : ai.candidates()) {
+        int score = score_move(ai, idx, player, ply);
+        if (idx == best_tt_move) score += 200000000; // PV move receives massive bonus
+        moves.push_back({score, idx});
     }
     
     // Sort descending (best moves first)
@@ -315,52 +729,132 @@ std::vector<std::pair<int, int>> get_sorted_moves(const GomokuAI& ai, int player
     return moves;
 }
 
-// --- SEARCH ---
-
-bool check_threat(const std::vector<int>& board, int idx, int w, int h, int player) {
-    int x = idx % w;
-    int y = idx / w;
-    int dx[] = {1, 0, 1, -1};
-    int dy[] = {0, 1, 1, 1};
-
-    for (int d = 0; d < 4; ++d) {
-        int count = 1;
-        for (int i = 1; i < 5; ++i) {
-            int nx = x + i * dx[d];
-            int ny = y + i * dy[d];
-            if (nx < 0 || nx >= w || ny < 0 || ny >= h || board[ny * w + nx] != player) break;
-            count++;
+// Cells worth answering with when the opponent threatens to win, or an empty
+// list when the position is quiet. Assumes neither side can win at once with
+// two opponent win squares, which negamax settles before generating moves.
+//  - one opponent win square: only the block stops five
+//  - opponent four squares that would make two win squares (open threes,
+//    double fours): a defense has to take that square or one of the win
+//    squares it would make, for every such square; our own fours, which
+//    force an answer first, stay playable too
+std::vector<int> forced_replies(const GomokuAI& ai, int player) {
+    static const int dx[] = {1, 0, 1, -1};
+    static const int dy[] = {0, 1, 1, 1};
+    int opp = (player == 1) ? 2 : 1;
+    const CellSet& opp_wins = ai.win_squares(opp);
+    if (!opp_wins.empty()) return {opp_wins[0]};
+
+    std::vector<int> zone; // cells stopping every threat seen so far
+    bool threatened = false;
+    int made[20];
+    for (int c : ai.four_squares(opp)) {
+        int x = c % ai.width;
+        int y = c / ai.width;
+        int n = 0;
+        for (int k = 0; k < 4; ++k) {
+            for (int j = 0; j < 5; ++j) {
+                int sx = x - j * dx[k], sy = y - j * dy[k];
+                int ex = sx + 4 * dx[k], ey = sy + 4 * dy[k];
+                if (sx < 0 || sx >= ai.width || sy < 0 || ex < 0 || ex >= ai.width || ey >= ai.height) continue;
+                int own = 0, other = -1;
+                for (int i = 0; i < 5; ++i) {
+                    int cell = (sy + i * dy[k]) * ai.width + sx + i * dx[k];
+                    if (ai.board[cell] == opp) ++own;
+                    else if (ai.board[cell] == player) { own = -5; break; }
+                    else if (cell != c) other = cell;
+                }
+                if (own == 3 && std::find(made, made + n, other) == made + n) made[n++] = other;
+            }
         }
-        for (int i = 1; i < 5; ++i) {
-            int nx = x - i * dx[d];
-            int ny = y - i * dy[d];
-            if (nx < 0 || nx >= w || ny < 0 || ny >= h || board[ny * w + nx] != player) break;
-            count++;
+        if (n < 2) continue;
+
+        made[n++] = c;
+        if (!threatened) {
+            zone.assign(made, made + n);
+            threatened = true;
+        } else {
+            zone.erase(std::remove_if(zone.begin(), zone.end(),
+                                      [&](int z) { return std::find(made, made + n, z) == made + n; }),
+                       zone.end());
         }
-        if (count == 4) return true;
     }
-    return false;
+    if (!threatened) return {};
+
+    for (int f : ai.four_squares(player)) {
+        if (std::find(zone.begin(), zone.end(), f) == zone.end()) zone.push_back(f);
+    }
+    // Lost anyway: search everything rather than nothing
+    if (zone.empty()) return {};
+    return zone;
 }
 
-int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply) {
+// --- SEARCH ---
+
+constexpr int EXT_FOUR_PLIES = ONE_PLY;           // answering a four
+constexpr int EXT_OPEN_THREE_PLIES = ONE_PLY / 2; // answering an open three
+constexpr int EXT_SINGLE_REPLY_PLIES = ONE_PLY / 2;
+constexpr int EXT_SINGULAR_PLIES = ONE_PLY;
+constexpr int EXTENSION_BUDGET = 8 * ONE_PLY;     // per path from the root
+constexpr int SINGULAR_MIN_DEPTH = 6 * ONE_PLY;
+constexpr int SINGULAR_MARGIN = 200;              // eval units below the TT score
+
+// excluded >= 0 searches the node without that move (singular extension
+// test); such searches neither use nor fill the TT entry of the node.
+// `extended` is what extensions already added on the path to this node.
+int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply, int extended, int excluded) {
     if (time_out_flag || check_time()) return TIMEOUT_SCORE;
 
     int opponent = (player == 1) ? 2 : 1;
     uint64_t key = ai.get_hash_key();
-    TTEntry& tte = TT[key % TT_SIZE];
+    TTData tte;
+    bool tt_hit = tt_probe(key, tte);
 
-    if (tte.key == key && tte.depth >= depth) {
+    if (excluded < 0 && tt_hit && tte.depth >= depth) {
         if (tte.flag == 0) return tte.value;
         if (tte.flag == 1 && tte.value >= beta) return tte.value;
         if (tte.flag == 2 && tte.value <= alpha) return tte.value;
     }
 
-    if (depth == 0) return eval_state(ai, player);
+    // A win square for the side to move ends the game now; two for the
+    // opponent cannot both be blocked
+    if (!ai.win_squares(player).empty()) return SCORE_WIN - ply;
+    if (ai.win_squares(opponent).size() >= 2) return -(SCORE_WIN - ply - 1);
+
+    // Being forced is decided before the horizon so that a threat made by the
+    // last move is still answered in the search, not left to the evaluation
+    std::vector<int> replies = forced_replies(ai, player);
+    unsigned enabled = ai.get_extensions();
+    int ext = 0;
+    if (!replies.empty() && excluded < 0) {
+        if (!ai.win_squares(opponent).empty()) {
+            if (enabled & EXT_FOUR) ext += EXT_FOUR_PLIES;
+        } else if (enabled & EXT_OPEN_THREE) {
+            ext += EXT_OPEN_THREE_PLIES;
+        }
+        if (replies.size() == 1 && (enabled & EXT_SINGLE_REPLY)) ext += EXT_SINGLE_REPLY_PLIES;
+        ext = std::min({ext, ONE_PLY, EXTENSION_BUDGET - extended});
+        depth += ext;
+        extended += ext;
+    }
+
+    if (depth < ONE_PLY) return cached_eval(ai, player);
+
+    int tt_move = tt_hit ? tte.best_move_idx : -1;
+    auto moves = get_sorted_moves(ai, player, ply, tt_move, replies);
 
-    int tt_move = (tte.key == key) ? tte.best_move_idx : -1;
-    auto moves = get_sorted_moves(ai, player, ply, tt_move);
+    if (moves.empty()) return cached_eval(ai, player);
 
-    if (moves.empty()) return eval_state(ai, player);
+    // Singular extension: the TT move gets an extra ply when every other move,
+    // searched at half depth, stays well below its (lower bound) score
+    int singular_ext = 0;
+    if ((enabled & EXT_SINGULAR) && excluded < 0 && replies.empty() && depth >= SINGULAR_MIN_DEPTH &&
+        tt_move >= 0 && ai.board[tt_move] == 0 && tte.flag != 2 && tte.depth >= depth - 3 * ONE_PLY &&
+        std::abs(tte.value) < SCORE_WIN - 1000 && extended + EXT_SINGULAR_PLIES <= EXTENSION_BUDGET) {
+        int singular_beta = tte.value - SINGULAR_MARGIN;
+        int val = negamax(ai, depth / 2, singular_beta - 1, singular_beta, player, ply, extended, tt_move);
+        if (time_out_flag) return TIMEOUT_SCORE;
+        if (val < singular_beta) singular_ext = EXT_SINGULAR_PLIES;
+    }
 
     int best_val = -INF;
     int best_move = -1;
@@ -368,12 +862,13 @@ int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply) {
 
     for (const auto& mv : moves) {
         int idx = mv.second;
-        
-        ai.update_board(idx % ai.width, idx / ai.width, player);
+        if (idx == excluded) continue;
+
+        ai.make_move(idx, player);
         
         // Immediate win check optimization
         if (check_win(ai.board, idx, ai.width, ai.height, player)) {
-            ai.update_board(idx % ai.width, idx / ai.width, 0);
+            ai.unmake_move();
             best_val = SCORE_WIN - ply; // Prefer faster wins
             best_move = idx;
             flag = 0; // Exact
@@ -381,16 +876,9 @@ int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply) {
             break; 
         }
 
-        // Search Extension: If move is forcing (creates a 4), do not reduce depth near leaves
-        int next_depth = depth - 1;
-        if (depth <= 2 && ply < 30) {
-            if (check_threat(ai.board, idx, ai.width, ai.height, player)) {
-                next_depth = depth; // Extend
-            }
-        }
-
-        int val = -negamax(ai, next_depth, -beta, -alpha, opponent, ply + 1);
-        ai.update_board(idx % ai.width, idx / ai.width, 0);
+        int move_ext = idx == tt_move ? singular_ext : 0;
+        int val = -negamax(ai, depth - ONE_PLY + move_ext, -beta, -alpha, opponent, ply + 1, extended + move_ext);
+        ai.unmake_move();
 
         if (time_out_flag) return TIMEOUT_SCORE;
 
@@ -402,136 +890,300 @@ int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply) {
         alpha = std::max(alpha, best_val);
         if (alpha >= beta) {
             flag = 1; // Lowerbound
-            if (ply < 100) { // Update Killers
-                killer_moves[ply][1] = killer_moves[ply][0];
-                killer_moves[ply][0] = idx;
+            if (ply < GomokuAI::MAX_KILLER_PLY) { // Update Killers
+                ai.killer_moves[ply][1] = ai.killer_moves[ply][0];
+                ai.killer_moves[ply][0] = idx;
             }
-            history_moves[player][idx] += depth * depth;
+            ai.history_moves[(player - 1) * ai.width * ai.height + idx] += (depth / ONE_PLY) * (depth / ONE_PLY);
             break; 
         }
     }
 
+    if (best_move < 0) return alpha; // only the excluded move was left
 
-    if (!time_out_flag) {
-        tte.key = key;
-        tte.depth = depth;
-        tte.value = best_val;
-        tte.flag = flag;
-        tte.best_move_idx = best_move;
+    if (!time_out_flag && excluded < 0) {
+        tt_store(key, {depth, best_val, flag, best_move});
     }
 
     return best_val;
 }
 
+// --- HELPER THREADS ---
+
+SearchPool::~SearchPool() {
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void SearchPool::run(int n, const std::function<void(int)>& f) {
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        while (static_cast<int>(threads.size()) < n - 1) {
+            threads.emplace_back(&SearchPool::loop, this, static_cast<int>(threads.size()) + 1, round);
+        }
+        job = &f;
+        active = n;
+        pending = n - 1;
+        ++round;
+    }
+    wake.notify_all();
+    f(0);
+    std::unique_lock<std::mutex> hold(lock);
+    finished.wait(hold, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+// Helper `self`: runs its part of every round it belongs to
+void SearchPool::loop(int self, uint64_t seen) {
+    std::unique_lock<std::mutex> hold(lock);
+    for (;;) {
+        wake.wait(hold, [&] { return quit || round != seen; });
+        if (quit) return;
+        seen = round;
+        if (self >= active) continue;
+        hold.unlock();
+        (*job)(self);
+        hold.lock();
+        if (--pending == 0) finished.notify_one();
+    }
+}
+
+// --- PARALLEL ROOT SEARCH ---
+
+struct RootQueue {
+    std::mutex lock;
+    std::deque<int> orders; // positions in the sorted root move list
+};
+
+// Takes the next move from the worker's own queue, otherwise steals the
+// least promising move left in another worker's queue.
+static int next_root_move(std::vector<RootQueue>& queues, int self) {
+    int n = static_cast<int>(queues.size());
+    for (int i = 0; i < n; ++i) {
+        RootQueue& q = queues[(self + i) % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.orders.empty()) continue;
+        int order;
+        if (i == 0) { order = q.orders.front(); q.orders.pop_front(); }
+        else { order = q.orders.back(); q.orders.pop_back(); }
+        return order;
+    }
+    return -1;
+}
+
+// Orders root results by score, then by move order so ties do not depend on thread timing
+static uint64_t pack_root_result(int val, int order) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(val) ^ 0x80000000u) << 32
+         | (0xFFFFFFFFu - static_cast<uint32_t>(order));
+}
+
+// Searches every root move at `depth` on `threads` workers sharing alpha.
+// Worker 0 searches on `ai` itself, so its killers and history are kept;
+// the helpers start from copies of them.
+// Returns {value, idx} of the best move, or {-INF, -1} if time ran out.
+static std::pair<int, int> search_root_parallel(GomokuAI& ai, const std::vector<std::pair<int, int>>& moves,
+                                                int depth, int threads) {
+    int n = static_cast<int>(moves.size());
+    std::vector<RootQueue> queues(threads);
+    for (int order = 0; order < n; ++order) queues[order % threads].orders.push_back(order);
+
+    std::atomic<int> shared_alpha(-INF);
+    std::atomic<uint64_t> best(0);
+    // Copied before worker 0 starts moving stones on `ai`
+    std::vector<GomokuAI> copies(threads - 1, ai);
+
+    auto worker = [&](int self) {
+        if (self != 0) nodes_visited = 0;
+        GomokuAI& local = self == 0 ? ai : copies[self - 1];
+        for (int order; (order = next_root_move(queues, self)) != -1;) {
+            if (time_out_flag) break;
+            int idx = moves[order].second;
+            // Search one below alpha so a tie is still an exact score and goes to the earlier move
+            int alpha = shared_alpha.load();
+            if (alpha > -INF) --alpha;
+
+            local.make_move(idx, 1);
+            int val = check_win(local.board, idx, local.width, local.height, 1)
+                ? SCORE_WIN
+                : -negamax(local, (depth - 1) * ONE_PLY, -INF, -alpha, 2, 1);
+            local.unmake_move();
+
+            if (time_out_flag) break;
+            if (val <= alpha) continue; // fail-low: cannot be the best move
+
+            uint64_t packed = pack_root_result(val, order);
+            uint64_t cur = best.load();
+            while (packed > cur && !best.compare_exchange_weak(cur, packed)) {}
+            int cur_alpha = shared_alpha.load();
+            while (val > cur_alpha && !shared_alpha.compare_exchange_weak(cur_alpha, val)) {}
+        }
+        if (self != 0) flush_nodes();
+    };
+
+    ai.run_parallel(threads, worker);
+
+    if (time_out_flag || best.load() == 0) return {-INF, -1};
+    uint64_t packed = best.load();
+    int val = static_cast<int32_t>(static_cast<uint32_t>(packed >> 32) ^ 0x80000000u);
+    int order = static_cast<int>(0xFFFFFFFFu - static_cast<uint32_t>(packed));
+    return {val, moves[order].second};
+}
+
 Point GomokuAI::find_best_move(int time_limit) {
+    SearchLimits limits;
+    limits.max_time = time_limit;
+    return find_best_move(limits);
+}
+
+Point GomokuAI::find_best_move(const SearchLimits& limits) {
     // 1. Initialization
+    int time_limit = limits.max_time;
+    int depth_limit = limits.max_depth > 0 ? limits.max_depth : max_depth;
+    int threads = num_threads;
     start_time = std::chrono::steady_clock::now();
-    time_limit_ms = std::max(100, time_limit - 50); // Safety buffer
-    guard_time_ms = std::min(4800, std::max(0, time_limit_ms - 200)); 
+    // Callers keep their own margin for replying (see Protocol::play_move);
+    // no time limit: search until max depth or stop_search()
+    guard_time_ms = time_limit > 0 ? time_limit : std::numeric_limits<int>::max();
+    best_so_far = -1;
+    node_limit = limits.max_nodes > 0 ? limits.max_nodes : std::numeric_limits<uint64_t>::max();
     nodes_visited = 0;
-    time_out_flag = false;
+    shared_nodes = 0;
+    time_out_flag = stop_requested.load();
+    stats = {0, 0, 0};
+    lines.clear();
 
     // Center start if empty
-    int center_idx = (height / 2) * width + (width / 2);
-    if (board[center_idx] == 0) {
-        bool empty = true;
-        for (int c : board) if (c != 0) { empty = false; break; }
-        if (empty) return {width / 2, height / 2};
+    if (stone_set.empty()) {
+        lines = {{{width / 2, height / 2}, 0, {{width / 2, height / 2}}}};
+        return {width / 2, height / 2};
     }
 
     // --- Tactical pre-pass: win-now or block immediate threats (4 open/broken) ---
-    auto would_win = [&](int idx, int player) {
-        update_board(idx % width, idx / width, player);
-        bool win = check_win(board, idx, width, height, player);
-        update_board(idx % width, idx / width, 0);
-        return win;
-    };
-
-    int margin = 5; // Increased margin for safety
-    int sx_t = std::max(0, min_x - margin);
-    int ex_t = std::min(width - 1, max_x + margin);
-    int sy_t = std::max(0, min_y - margin);
-    int ey_t = std::min(height - 1, max_y + margin);
+    // Read straight off the threat registry; the lowest cell is taken so the
+    // answer does not depend on the order the stones arrived in.
+    auto lowest = [](const CellSet& set) { return *std::min_element(set.begin(), set.end()); };
 
     // Priority 1: Immediate win for us
-    for (int y = sy_t; y <= ey_t; ++y) {
-        for (int x = sx_t; x <= ex_t; ++x) {
-            int idx = y * width + x;
-            if (board[idx] != 0) continue;
-            if (would_win(idx, 1)) return {x, y};
-        }
+    if (!win_squares(1).empty()) {
+        int idx = lowest(win_squares(1));
+        Point p{idx % width, idx / width};
+        stats.score = SCORE_WIN;
+        lines = {{p, SCORE_WIN, {p}}};
+        return p;
     }
 
     // Priority 2: Forced Defense (Instant Block)
     // If opponent has a winning move, we MUST block it unless we won above.
     // If there is exactly ONE winning spot for them (e.g. X X X X .), block it instantly.
     // If there are multiple (double threat), we let Negamax try to handle the desperate situation.
-    std::vector<Point> forcing_blocks;
-    for (int y = sy_t; y <= ey_t; ++y) {
-        for (int x = sx_t; x <= ex_t; ++x) {
-            int idx = y * width + x;
-            if (board[idx] != 0) continue;
-            if (would_win(idx, 2)) {
-                forcing_blocks.push_back({x, y});
-            }
-        }
-    }
-    if (forcing_blocks.size() == 1) {
-        return forcing_blocks[0];
+    if (win_squares(2).size() == 1) {
+        int idx = win_squares(2)[0];
+        Point p{idx % width, idx / width};
+        lines = {{p, 0, {p}}};
+        return p;
     }
 
     // REMOVED Priority 2 & 3: Let negamax handle blocking to find the best defense (counter-attack)
     // instead of blindly picking the first blocking move.
 
-    Point best_move_global = {-1, -1};
-    
+    // Positions proven by an earlier search, possibly in an earlier game, need no search.
+    // Fixed-budget searches leave the store alone so their results do not depend on it.
+    bool use_proven = !limits.fixed_budget();
+    uint64_t proven_key = ProvenResults::key_for(hash_key, width);
+    ProvenEntry proven;
+    if (use_proven && proven_results().probe(proven_key, proven) &&
+        proven.move >= 0 && proven.move < width * height && board[proven.move] == 0) {
+        Point p = {proven.move % width, proven.move / width};
+        stats.score = proven.score;
+        lines = {{p, proven.score, {p}}};
+        return p;
+    }
+
     // Quick scan for immediate winning/blocking moves (Depth 1 equivalent)
     auto initial_moves = get_sorted_moves(*this, 1, 0);
     if (!initial_moves.empty()) {
-        best_move_global = Point{initial_moves[0].second % width, initial_moves[0].second / width};
+        best_so_far = initial_moves[0].second;
     } else {
         // Should not happen unless board full
         for(int i=0; i<width*height; ++i) if(board[i]==0) return {i%width, i/width};
         return {0,0};
     }
 
+    if (backend == SearchBackend::MCTS) {
+        bool bounded = time_limit > 0 || limits.max_nodes > 0;
+        uint64_t playouts = bounded ? 0 : static_cast<uint64_t>(depth_limit) * MCTS_PLAYOUTS_PER_DEPTH;
+        auto mcts_lines = mcts_search(*this, threads, playouts, mcts_arena_bytes(), multipv, stats.depth);
+        stats.nodes = shared_nodes + nodes_visited;
+        if (!mcts_lines.empty()) {
+            stats.score = mcts_lines[0].score;
+            lines = std::move(mcts_lines);
+            return lines[0].move;
+        }
+        stats.depth = 0;
+    }
+
+    Point best_move_global = {initial_moves[0].second % width, initial_moves[0].second / width};
+
     // 3. Iterative Deepening Loop
-    int max_depth = 20;
-    for (int depth = 1; depth <= max_depth; ++depth) {
-        int best_val_this_depth = -INF;
-        int best_move_idx_this_depth = -1;
-        
+    for (int depth = 1; depth <= depth_limit; ++depth) {
+        std::vector<RootLine> depth_lines;
+
         // Use consistent move ordering
         auto moves = get_sorted_moves(*this, 1, 0, -1);
-        
-        int alpha = -INF;
-        int beta = INF;
 
-        for (const auto& mv : moves) {
-            int idx = mv.second;
-            update_board(idx % width, idx / width, 1);
+        if (threads > 1 && multipv == 1 && moves.size() > 1) {
+            auto [val, idx] = search_root_parallel(*this, moves, depth, threads);
+            if (idx != -1) depth_lines.push_back({{idx % width, idx / width}, val, principal_variation(idx, depth)});
+            moves.clear();
+        }
 
-            // Win check
-            if (check_win(board, idx, width, height, 1)) {
-                update_board(idx % width, idx / width, 0);
-                return {idx % width, idx / width}; // Return immediately on sure win
-            }
+        // Line k is the best of the root moves not already ranked, searched with a full window
+        std::vector<bool> ranked(width * height, false);
+        for (int line = 0; line < multipv && line < static_cast<int>(moves.size()); ++line) {
+            int best_val_this_line = -INF;
+            int best_move_idx_this_line = -1;
+            int alpha = -INF;
+            int beta = INF;
+
+            for (const auto& mv : moves) {
+                int idx = mv.second;
+                if (ranked[idx]) continue;
+                make_move(idx, 1);
+
+                // Win check
+                if (check_win(board, idx, width, height, 1)) {
+                    unmake_move();
+                    stats.score = SCORE_WIN;
+                    lines = {{{idx % width, idx / width}, SCORE_WIN, {{idx % width, idx / width}}}};
+                    return {idx % width, idx / width}; // Return immediately on sure win
+                }
 
-            int val = -negamax(*this, depth - 1, -beta, -alpha, 2, 1);
-            update_board(idx % width, idx / width, 0);
+                int val = -negamax(*this, (depth - 1) * ONE_PLY, -beta, -alpha, 2, 1);
+                unmake_move();
 
-            // CRITICAL: Timeout Check
-            if (time_out_flag || val == TIMEOUT_SCORE) {
-                time_out_flag = true;
-                break; // Break the move loop
-            }
+                // CRITICAL: Timeout Check
+                if (time_out_flag || val == TIMEOUT_SCORE) {
+                    time_out_flag = true;
+                    break; // Break the move loop
+                }
 
-            if (val > best_val_this_depth) {
-                best_val_this_depth = val;
-                best_move_idx_this_depth = idx;
+                if (val > best_val_this_line) {
+                    best_val_this_line = val;
+                    best_move_idx_this_line = idx;
+                }
+                alpha = std::max(alpha, best_val_this_line);
             }
-            alpha = std::max(alpha, best_val_this_depth);
+            if (time_out_flag || best_move_idx_this_line == -1) break;
+
+            ranked[best_move_idx_this_line] = true;
+            depth_lines.push_back({{best_move_idx_this_line % width, best_move_idx_this_line / width},
+                                   best_val_this_line, principal_variation(best_move_idx_this_line, depth)});
         }
+        stats.nodes = shared_nodes + nodes_visited;
 
         // CRITICAL: Fallback Logic
         if (time_out_flag) {
@@ -540,14 +1192,41 @@ Point GomokuAI::find_best_move(int time_limit) {
             break;
         } else {
             // Depth completed successfully, commit this move as the new best
-            if (best_move_idx_this_depth != -1) {
-                best_move_global = {best_move_idx_this_depth % width, best_move_idx_this_depth / width};
-                
+            if (!depth_lines.empty()) {
+                best_move_global = depth_lines[0].move;
+                best_so_far = best_move_global.y * width + best_move_global.x;
+                stats.score = depth_lines[0].score;
+                stats.depth = depth;
+                lines = std::move(depth_lines);
+
                 // If we found a winning sequence, no need to search deeper
-                if (best_val_this_depth >= SCORE_WIN - 1000) return best_move_global;
+                if (stats.score >= SCORE_WIN - 1000) break;
             }
         }
     }
 
+    if (use_proven && stats.depth > 0 && std::abs(stats.score) >= SCORE_WIN - 1000) {
+        proven_results().store(proven_key, stats.score, best_move_global.y * width + best_move_global.x);
+    }
+    if (lines.empty()) lines = {{best_move_global, 0, {best_move_global}}};
     return best_move_global;
+}
+
+// Follows the TT best moves from root_idx; at most `depth` moves, stopping at a win
+std::vector<Point> GomokuAI::principal_variation(int root_idx, int depth) {
+    std::vector<Point> pv;
+    int idx = root_idx;
+    int player = 1;
+    TTData tte;
+    while (true) {
+        pv.push_back({idx % width, idx / width});
+        make_move(idx, player);
+        bool win = check_win(board, idx, width, height, player);
+        player = 3 - player;
+        if (win || static_cast<int>(pv.size()) >= depth || !tt_probe(hash_key, tte)) break;
+        idx = tte.best_move_idx;
+        if (idx < 0 || idx >= width * height || board[idx] != 0) break;
+    }
+    for (size_t i = 0; i < pv.size(); ++i) unmake_move();
+    return pv;
 }
\ No newline at end of file
@@ -2,33 +2,338 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "EvalParams.hpp"
+#include "NNUE.hpp"
 
 struct Point {
     int x;
     int y;
 };
 
+// Outcome of the last find_best_move, from the side to move's point of view
+struct SearchStats {
+    int score;      // 0 when the move came from the tactical pre-pass without a search
+    int depth;      // last fully searched depth
+    uint64_t nodes;
+};
+
+// One root move of a multi-PV search, best first. pv starts with move and
+// follows the transposition table, so it may be shorter than the depth.
+struct RootLine {
+    Point move;
+    int score;
+    std::vector<Point> pv;
+};
+
+// Any combination of limits; 0 leaves that dimension unbounded. The node
+// limit counts the nodes of every search thread together. A fixed-budget
+// search (a depth or node limit, no time limit) leaves the proven-results
+// store alone; on one thread (set_threads(1)) the same init() and move
+// sequence then gives the same move, score and node count bit for bit.
+// Parallel searches are not deterministic: which thread takes which move,
+// and what it finds in the shared tables, depends on timing.
+struct SearchLimits {
+    int max_depth = 0;      // 0: the engine's set_max_depth() value
+    uint64_t max_nodes = 0;
+    int max_time = 0;       // milliseconds; the search stops itself once they have passed
+
+    bool fixed_budget() const { return max_time <= 0 && (max_depth > 0 || max_nodes > 0); }
+};
+
+// Search extensions, combinable as a mask for set_extensions()
+enum Extension : unsigned {
+    EXT_FOUR = 1,         // answering a four
+    EXT_OPEN_THREE = 2,   // answering an open three (or another four-making threat)
+    EXT_SINGLE_REPLY = 4, // only one move stops the threat
+    EXT_SINGULAR = 8,     // TT move much better than every alternative
+    EXT_ALL = 15
+};
+
+// Largest supported board side: cell indices have to fit the 15-bit move
+// field of transposition table entries. The board and its per-cell tables
+// stay dense, width * height entries each; the searches' scans and the
+// Zobrist keys scale with the stones instead.
+constexpr int MAX_BOARD_SIZE = 181;
+
+// Search algorithm behind find_best_move
+enum class SearchBackend {
+    AlphaBeta, // iterative deepening negamax
+    MCTS       // PUCT tree search, see MCTS.hpp
+};
+
+// Cell indices with O(1) insert, erase and membership (sparse set)
+class CellSet {
+public:
+    void reset(int cells) { list.clear(); pos.assign(cells, -1); }
+    bool contains(int idx) const { return pos[idx] >= 0; }
+    void insert(int idx) {
+        pos[idx] = static_cast<int>(list.size());
+        list.push_back(idx);
+    }
+    // Returns where idx was in the list
+    int erase(int idx) {
+        int at = pos[idx];
+        int last = list.back();
+        list[at] = last;
+        pos[last] = at;
+        list.pop_back();
+        pos[idx] = -1;
+        return at;
+    }
+    // Undoes the erase(idx) that returned `at`, restoring the list order
+    void restore(int idx, int at) {
+        if (at < static_cast<int>(list.size())) {
+            int moved = list[at];
+            pos[moved] = static_cast<int>(list.size());
+            list.push_back(moved);
+            list[at] = idx;
+        } else {
+            list.push_back(idx);
+        }
+        pos[idx] = at;
+    }
+    size_t size() const { return list.size(); }
+    bool empty() const { return list.empty(); }
+    int operator[](size_t i) const { return list[i]; }
+    std::vector<int>::const_iterator begin() const { return list.begin(); }
+    std::vector<int>::const_iterator end() const { return list.end(); }
+
+private:
+    std::vector<int> list;
+    std::vector<int> pos; // index in list, -1 when absent
+};
+
+// Helper threads of one engine, started on first use and kept until the
+// engine is destroyed, so a search hands them work instead of spawning
+// threads. A copy of an engine starts without helpers of its own.
+class SearchPool {
+public:
+    SearchPool() = default;
+    SearchPool(const SearchPool&) {}
+    SearchPool& operator=(const SearchPool&) { return *this; }
+    ~SearchPool();
+    // Runs job(0) on the calling thread and job(1) .. job(n - 1) on helpers;
+    // returns once all of them have
+    void run(int n, const std::function<void(int)>& job);
+
+private:
+    std::vector<std::thread> threads; // threads[i] runs job(i + 1)
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(int)>* job = nullptr;
+    int active = 0;           // job indices below this run in the current round
+    int pending = 0;          // helpers still running the current round
+    uint64_t round = 0;
+    bool quit = false;
+
+    void loop(int self, uint64_t seen);
+};
+
+// Bytes held by each engine structure, counting every search thread
+struct MemoryUsage {
+    size_t tt = 0;
+    size_t eval_cache = 0;
+    size_t history = 0; // killer and history tables
+    size_t search = 0;  // board copies, undo stacks and move lists
+    size_t nnue = 0;    // network weights and accumulators
+    size_t mcts = 0;    // tree arena budget, with the MCTS backend
+
+    size_t total() const { return tt + eval_cache + history + search + nnue + mcts; }
+};
+
+// One value make_move() overwrote. For a byte table (UndoChange::NEIGHBORS to
+// THREAT_REFS) `old` is the byte at index `at`; for a cell set (STONES and up)
+// `at` is the cell, `old` whether it was in the set and `pos` where it sat.
+struct UndoChange {
+    enum : uint8_t { NEIGHBORS, RUNS, WINDOWS, THREAT_REFS, STONES, CANDIDATES, THREATS };
+    uint8_t table;
+    uint8_t old;
+    int32_t pos;
+    int32_t at;
+};
+
+// Everything make_move() changes, so unmake_move() can restore it verbatim:
+// the scalars here and undo_changes[first_change..] for the tables.
+struct UndoEntry {
+    int idx;
+    uint64_t hash_key;
+    int min_x, max_x, min_y, max_y;
+    size_t first_change;
+};
+
 class GomokuAI {
 public:
     GomokuAI();
     void init(int size);
     void update_board(int x, int y, int player);
-    Point find_best_move(int time_limit = 1000);
-    Point parse_coordinates(const std::string& s);
+    // Brings the board to `target` (width * height cells of 0/1/2) by
+    // updating only the cells that differ. Unlike init(), it keeps the TT,
+    // eval cache and the engine's killer and history tables, which stay
+    // valid for any position.
+    // Returns the number of cells changed, or -1 if target has the wrong size.
+    int sync_board(const std::vector<int>& target);
+    Point find_best_move(int time_limit = 1000); // time_limit <= 0: no limit
+    Point find_best_move(const SearchLimits& limits);
+
+    // Thread-safe: makes a running find_best_move return its best move so far.
+    // The request sticks (later searches return at once) until clear_stop(),
+    // which also forgets best_move_so_far().
+    void stop_search();
+    void clear_stop();
+    // Thread-safe: the move the running (or last) search would play if it were
+    // stopped now, {-1, -1} before it has one. Set as soon as the root moves
+    // are ordered, then after every completed depth.
+    Point best_move_so_far() const;
+    Point parse_coordinates(std::string_view s);
     uint64_t get_hash_key() const { return hash_key; }
 
+    const SearchStats& last_search() const { return stats; }
+    void set_max_depth(int depth) { max_depth = depth < 1 ? 1 : depth; }
+
+    // Both backends take the same limits and skip the search after the
+    // tactical pre-pass. Without a time or node limit, MCTS runs
+    // MCTS_PLAYOUTS_PER_DEPTH playouts per ply of the depth limit.
+    void set_backend(SearchBackend b);
+    SearchBackend get_backend() const { return backend; }
+
+    // Extensions add fractional plies to forcing lines, within a budget per
+    // path; switch them off individually to measure what each one buys.
+    void set_extensions(unsigned mask) { extensions = mask & EXT_ALL; }
+    unsigned get_extensions() const { return extensions; }
+
+    // Multi-PV: each depth also ranks the next n-1 best root moves with exact
+    // scores, by re-searching the root without the moves already ranked.
+    // Multi-PV searches run on one thread.
+    void set_multipv(int n) { multipv = n < 1 ? 1 : n; }
+    int get_multipv() const { return multipv; }
+    // Lines of the last fully searched depth (a single line when the
+    // tactical pre-pass decided)
+    const std::vector<RootLine>& last_lines() const { return lines; }
+
+    // Hand-tuned evaluation of the position for `player` with `params`
+    int static_eval(int player) const;
+    // Move-ordering score of playing idx, without killer/history bonuses
+    int tactical_move_score(int idx, int player) const;
+
+    // True if the stone at idx is part of five or more in a row
+    bool is_five(int idx) const;
+    uint64_t zobrist_at(int idx, int player) const;
+
+    // Sizes the shared TT and eval cache so the whole process stays within
+    // `bytes` (0: default sizes, about 18 MB); applied now and at every init().
+    // Tables are shared by all engines, and resizing clears them.
+    void set_memory_limit(size_t bytes);
+    MemoryUsage memory_usage() const;
+
+    // Root moves are split across this many search threads (1 = sequential).
+    // Only a single-threaded search is reproducible (see SearchLimits).
+    void set_threads(int n) { num_threads = n < 1 ? 1 : n; }
+    int get_threads() const { return num_threads; }
+    // Runs job(0) on the calling thread and job(1) .. job(n - 1) on the
+    // engine's helper threads (see SearchPool)
+    void run_parallel(int n, const std::function<void(int)>& job) const { helpers.run(n, job); }
+
+    // Search fast path: idx must be an empty cell on the board.
+    void make_move(int idx, int player);
+    void unmake_move();
+
+    // Move ordering tables, filled by this engine's searches and kept from
+    // move to move until init(); helper threads of a search work on copies.
+    static constexpr int MAX_KILLER_PLY = 128;
+    int killer_moves[MAX_KILLER_PLY][2];
+    std::vector<int> history_moves; // [(player - 1) * cells + idx]
+    void clear_history();
+
     int width;
     int height;
     std::vector<int> board; // 1D array: board[y * width + x]
 
+    // Number of stones within distance 2 of each cell (candidate set)
+    std::vector<uint8_t> neighbors;
+
+    // Shape cache: for cell idx, direction k (horizontal, vertical, diagonal,
+    // anti-diagonal) and player p, runs[(idx * 4 + k) * 2 + p - 1] packs the
+    // number of consecutive p stones right after idx in direction k (low
+    // nibble) and right before it (high nibble), each capped at 4. Kept up to
+    // date for the four lines through every changed cell.
+    std::vector<uint8_t> runs;
+    int run_length(int idx, int k, int player) const {
+        uint8_t r = runs[(idx * 4 + k) * 2 + player - 1];
+        return (r & 0xF) + (r >> 4);
+    }
+
+    // Occupied cells, and the empty cells within distance 2 of a stone (the
+    // move candidates), so scans cost per stone rather than per board cell
+    const CellSet& stones() const { return stone_set; }
+    const CellSet& candidates() const { return candidate_set; }
+
+    // Threat registry, derived from the stone counts of every 5-cell window:
+    // win squares complete five for that player, four squares make a four
+    // (a new win square). Maintained on every board change.
+    const CellSet& win_squares(int player) const { return threat_sets[(player - 1) * 2]; }
+    const CellSet& four_squares(int player) const { return threat_sets[(player - 1) * 2 + 1]; }
+
     // Active bounds for optimization
     int min_x, max_x, min_y, max_y;
 
+    EvalParams params = default_eval_params;
+
+    // Neural evaluation backend: set by init() when a network for this board
+    // size is loaded, in which case it replaces eval_state at the leaves
+    const NNUENetwork* nnue = nullptr;
+    std::vector<int16_t> accumulator;
+
 private:
+    int num_threads = 1;
+    mutable SearchPool helpers;
+    int max_depth = 20;
+    int multipv = 1;
+    unsigned extensions = EXT_ALL;
+    SearchBackend backend = SearchBackend::AlphaBeta;
+    SearchStats stats = {0, 0, 0};
+    std::vector<RootLine> lines;
     uint64_t hash_key = 0;
-    std::vector<uint64_t> zobrist;
+    std::vector<UndoEntry> undo_stack;
+    // Filled while make_move() runs; unmake_move() replays it backwards
+    std::vector<UndoChange> undo_changes;
+    bool journaling = false;
 
-    void init_zobrist();
-    uint64_t zobrist_at(int idx, int player) const;
+    std::vector<Point> principal_variation(int root_idx, int depth);
+    void add_neighbors(int idx, int delta);
+    void refresh_candidate(int idx);
+    void update_runs(int idx);
+
+    // Stones of each player in the window starting at cell s in direction k:
+    // windows[s * 4 + k], player 1 in the low nibble, player 2 in the high one
+    std::vector<uint8_t> windows;
+    // threat_refs[idx * 4 + (p - 1) * 2 + kind]: windows making idx a win
+    // (kind 0) or four (kind 1) square for p; threat_sets lists the nonzero ones
+    std::vector<uint8_t> threat_refs;
+    CellSet threat_sets[4];
+    CellSet stone_set;
+    CellSet candidate_set;
+
+    void set_stone(int idx, int player);
+    void window_threats(int window, int delta);
+
+    // Table writes and set updates, logged to undo_changes while journaling
+    void log_byte(uint8_t table, int at, uint8_t old) {
+        if (journaling) undo_changes.push_back({table, old, 0, at});
+    }
+    void set_insert(uint8_t table, CellSet& set, int idx) {
+        set.insert(idx);
+        if (journaling) undo_changes.push_back({table, 0, 0, idx});
+    }
+    void set_erase(uint8_t table, CellSet& set, int idx) {
+        int at = set.erase(idx);
+        if (journaling) undo_changes.push_back({table, 1, at, idx});
+    }
 };
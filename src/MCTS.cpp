@@ -0,0 +1,262 @@
+#include "MCTS.hpp"
+#include "Search.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <new>
+
+constexpr int WIN_VALUE = 1000;           // results are in thousandths of a win
+constexpr int VIRTUAL_LOSS = WIN_VALUE;   // a playout in flight counts as a loss
+constexpr float C_PUCT = 1.5f;
+constexpr double VALUE_SCALE = 2000.0;    // eval units mapped to about 0.76 of a win
+constexpr size_t MAX_CHILDREN = 32;       // widest quiet node, best ordered moves first
+constexpr int LEAF_DEPTH = ONE_PLY;
+constexpr int MAX_PLY = 64;               // ply passed to the move ordering tables
+constexpr int PV_LENGTH = 32;
+
+enum : uint8_t { LEAF, EXPANDING, EXPANDED };
+
+// One position of the tree. Children are allocated together, so a node only
+// needs the first one and their count; both are written before `state`
+// becomes EXPANDED and read after it.
+struct Node {
+    std::atomic<int32_t> visits;
+    std::atomic<int64_t> value; // sum of results for the player who moved here
+    std::atomic<uint8_t> state;
+    uint16_t child_count;
+    int16_t move;
+    float prior;
+    Node* children;
+
+    void reset(int m, float p) {
+        visits.store(0, std::memory_order_relaxed);
+        value.store(0, std::memory_order_relaxed);
+        state.store(LEAF, std::memory_order_relaxed);
+        child_count = 0;
+        move = static_cast<int16_t>(m);
+        prior = p;
+        children = nullptr;
+    }
+};
+
+// Bump allocator over fixed-size chunks that are kept between searches.
+// Threads take ranges with one atomic add; a range that would straddle two
+// chunks is skipped, which wastes at most MAX_CHILDREN nodes per chunk.
+class NodeArena {
+public:
+    ~NodeArena() {
+        for (auto& c : chunks) delete[] c.load();
+    }
+
+    void reset(size_t max_nodes) {
+        used = 0;
+        limit = std::min(max_nodes, MAX_CHUNKS * CHUNK_NODES);
+    }
+
+    // n <= CHUNK_NODES contiguous nodes, or nullptr when the arena is full
+    Node* allocate(size_t n) {
+        for (;;) {
+            size_t start = used.fetch_add(n, std::memory_order_relaxed);
+            if (start + n > limit) return nullptr;
+            size_t c = start / CHUNK_NODES;
+            if ((start + n - 1) / CHUNK_NODES != c) continue;
+            Node* chunk = chunks[c].load(std::memory_order_acquire);
+            if (!chunk) {
+                std::lock_guard<std::mutex> hold(grow);
+                chunk = chunks[c].load(std::memory_order_relaxed);
+                if (!chunk) {
+                    chunk = new (std::nothrow) Node[CHUNK_NODES];
+                    if (!chunk) return nullptr;
+                    chunks[c].store(chunk, std::memory_order_release);
+                    ++allocated;
+                }
+            }
+            return chunk + start % CHUNK_NODES;
+        }
+    }
+
+    size_t bytes() const { return allocated.load() * CHUNK_NODES * sizeof(Node); }
+
+private:
+    static constexpr size_t CHUNK_NODES = 1 << 16;
+    static constexpr size_t MAX_CHUNKS = 1 << 12;
+
+    std::array<std::atomic<Node*>, MAX_CHUNKS> chunks{};
+    std::atomic<size_t> allocated{0};
+    std::atomic<size_t> used{0};
+    size_t limit = 0;
+    std::mutex grow;
+};
+
+static NodeArena arena;
+
+size_t mcts_memory() {
+    return arena.bytes();
+}
+
+// Adds the children of `node`, `player` to move on `ai`: the forced replies
+// when there is a threat to answer, otherwise the best ordered candidates.
+// Priors fall off with the move ordering rank.
+static bool expand(Node& node, const GomokuAI& ai, int player, int ply) {
+    auto moves = get_sorted_moves(ai, player, std::min(ply, MAX_PLY), -1, forced_replies(ai, player));
+    size_t n = std::min(moves.size(), MAX_CHILDREN);
+    Node* kids = n > 0 ? arena.allocate(n) : nullptr;
+    if (n > 0 && !kids) return false;
+
+    float total = 0.0f;
+    for (size_t i = 0; i < n; ++i) total += 1.0f / static_cast<float>(i + 1);
+    for (size_t i = 0; i < n; ++i) kids[i].reset(moves[i].second, 1.0f / static_cast<float>(i + 1) / total);
+    node.children = kids;
+    node.child_count = static_cast<uint16_t>(n);
+    node.state.store(EXPANDED, std::memory_order_release);
+    return true;
+}
+
+// PUCT: value from the parent's side plus an exploration bonus that shrinks
+// with the child's visits; virtual losses steer other threads elsewhere
+static Node* select_child(const Node& node) {
+    float sqrt_n = std::sqrt(static_cast<float>(std::max(node.visits.load(std::memory_order_relaxed), 1)));
+    Node* best = nullptr;
+    float best_score = -1e30f;
+    for (uint16_t i = 0; i < node.child_count; ++i) {
+        Node& c = node.children[i];
+        int32_t n = c.visits.load(std::memory_order_relaxed);
+        float q = n > 0 ? static_cast<float>(c.value.load(std::memory_order_relaxed)) / (WIN_VALUE * n) : 0.0f;
+        float score = q + C_PUCT * c.prior * sqrt_n / static_cast<float>(1 + n);
+        if (score > best_score) {
+            best_score = score;
+            best = &c;
+        }
+    }
+    return best;
+}
+
+// Result for `player` to move, in thousandths of a win. `terminal` marks a
+// decided position, which is never expanded. False if the search had to stop.
+static bool evaluate_leaf(GomokuAI& ai, int player, int ply, int& result, bool& terminal) {
+    int opp = (player == 1) ? 2 : 1;
+    terminal = true;
+    if (!ai.win_squares(player).empty()) {
+        result = WIN_VALUE;
+        return true;
+    }
+    if (ai.win_squares(opp).size() >= 2) {
+        result = -WIN_VALUE;
+        return true;
+    }
+    int score = negamax(ai, LEAF_DEPTH, -INF, INF, player, std::min(ply, MAX_PLY));
+    if (time_out_flag) return false;
+    if (std::abs(score) >= SCORE_WIN - 1000) {
+        result = score > 0 ? WIN_VALUE : -WIN_VALUE;
+        return true;
+    }
+    terminal = false;
+    result = static_cast<int>(std::lround(WIN_VALUE * std::tanh(score / VALUE_SCALE)));
+    return true;
+}
+
+// Selection, expansion, evaluation and backup of one playout. An interrupted
+// playout takes back its visits so no partial result is recorded.
+static void playout(Node& root, GomokuAI& ai, std::vector<Node*>& path, std::atomic<int>& max_depth) {
+    path.clear();
+    root.visits.fetch_add(1, std::memory_order_relaxed);
+    Node* node = &root;
+    int player = 1;
+    int result = 0;
+    bool terminal = false;
+    while (node->state.load(std::memory_order_acquire) == EXPANDED && node->child_count > 0) {
+        Node* child = select_child(*node);
+        child->visits.fetch_add(1, std::memory_order_relaxed);
+        child->value.fetch_sub(VIRTUAL_LOSS, std::memory_order_relaxed);
+        ai.make_move(child->move, player);
+        path.push_back(child);
+        node = child;
+        if (check_win(ai.board, child->move, ai.width, ai.height, player)) {
+            player = 3 - player;
+            result = -WIN_VALUE;
+            terminal = true;
+            break;
+        }
+        player = 3 - player;
+    }
+
+    int ply = static_cast<int>(path.size());
+    bool ok = terminal || evaluate_leaf(ai, player, ply, result, terminal);
+    uint8_t leaf = LEAF;
+    if (ok && !terminal && node->state.compare_exchange_strong(leaf, EXPANDING)) {
+        if (!expand(*node, ai, player, ply)) node->state.store(LEAF, std::memory_order_release);
+    }
+
+    // The leaf's mover scores -result; the sign alternates towards the root
+    int r = -result;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        (*it)->value.fetch_add(VIRTUAL_LOSS + (ok ? r : 0), std::memory_order_relaxed);
+        if (!ok) (*it)->visits.fetch_sub(1, std::memory_order_relaxed);
+        r = -r;
+    }
+    if (!ok) root.visits.fetch_sub(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < path.size(); ++i) ai.unmake_move();
+
+    int seen = max_depth.load(std::memory_order_relaxed);
+    while (ply > seen && !max_depth.compare_exchange_weak(seen, ply)) {}
+}
+
+static Node* most_visited(const Node& node) {
+    Node* best = nullptr;
+    for (uint16_t i = 0; i < node.child_count; ++i) {
+        Node& c = node.children[i];
+        if (!best || c.visits.load() > best->visits.load()) best = &c;
+    }
+    return best;
+}
+
+std::vector<RootLine> mcts_search(const GomokuAI& ai, int threads, uint64_t max_playouts, size_t arena_bytes,
+                                  int lines, int& depth) {
+    arena.reset(arena_bytes / sizeof(Node));
+    Node root;
+    root.reset(-1, 1.0f);
+    depth = 0;
+    if (!expand(root, ai, 1, 0) || root.child_count == 0) return {};
+
+    std::atomic<uint64_t> playouts(0);
+    std::atomic<int> max_depth(0);
+    auto worker = [&](int self) {
+        if (self != 0) nodes_visited = 0;
+        GomokuAI local = ai; // each worker owns a board copy
+        std::vector<Node*> path;
+        while (!time_out_flag) {
+            if (max_playouts > 0 && playouts.fetch_add(1) >= max_playouts) break;
+            if (check_time()) break;
+            playout(root, local, path, max_depth);
+        }
+        if (self != 0) flush_nodes();
+    };
+
+    ai.run_parallel(threads, worker);
+    depth = max_depth.load();
+
+    // Root moves by visits; the stable sort keeps move ordering for ties
+    std::vector<Node*> ranked;
+    for (uint16_t i = 0; i < root.child_count; ++i) ranked.push_back(&root.children[i]);
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const Node* a, const Node* b) { return a->visits.load() > b->visits.load(); });
+
+    std::vector<RootLine> result;
+    for (int k = 0; k < lines && k < static_cast<int>(ranked.size()); ++k) {
+        const Node* c = ranked[k];
+        int32_t n = c->visits.load();
+        double q = n > 0 ? static_cast<double>(c->value.load()) / (WIN_VALUE * n) : 0.0;
+        RootLine line;
+        line.move = {c->move % ai.width, c->move / ai.width};
+        line.score = static_cast<int>(VALUE_SCALE * std::atanh(std::clamp(q, -0.999, 0.999)));
+        for (const Node* p = c; p && static_cast<int>(line.pv.size()) < PV_LENGTH; p = most_visited(*p)) {
+            if (p->visits.load() == 0) break;
+            line.pv.push_back({p->move % ai.width, p->move / ai.width});
+            if (p->state.load() != EXPANDED) break;
+        }
+        result.push_back(std::move(line));
+    }
+    return result;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GomokuAI.hpp"
+
+// Monte Carlo tree search backend (PUCT). Each playout walks the shared tree
+// with virtual loss, so `threads` workers spread over different lines, and
+// values the new leaf with a one-ply alpha-beta search (forcing lines are
+// extended as in the main search). Runs inside find_best_move: it stops with
+// that search's time/node limits or stop_search(), or after `max_playouts`
+// (0: no cap).
+//
+// Returns up to `lines` root moves, most visited first (an empty list if the
+// root has no moves), and sets `depth` to the deepest tree node reached.
+// Tree nodes come from a process-wide arena of at most `arena_bytes`; once it
+// is full, leaves are still evaluated but no longer expanded.
+std::vector<RootLine> mcts_search(const GomokuAI& ai, int threads, uint64_t max_playouts, size_t arena_bytes,
+                                  int lines, int& depth);
+
+// Bytes the arena currently holds
+size_t mcts_memory();
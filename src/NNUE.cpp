@@ -0,0 +1,144 @@
+#include "NNUE.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static std::unique_ptr<NNUENetwork> loaded_net;
+
+// --- FILE I/O ---
+
+template <typename T>
+static bool read_pod(std::ifstream& in, T* data, size_t count) {
+    in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(in);
+}
+
+template <typename T>
+static void write_pod(std::ofstream& out, const T* data, size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+bool NNUENetwork::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    char magic[4];
+    uint32_t header[3];
+    int32_t output[2];
+    if (!read_pod(in, magic, 4) || std::memcmp(magic, "GNUE", 4) != 0) return false;
+    if (!read_pod(in, header, 3) || header[0] != VERSION) return false;
+    if (!read_pod(in, output, 2) || output[1] == 0) return false;
+    if (header[1] < 5 || header[1] > 256 || header[2] == 0 || header[2] % 32 != 0 || header[2] > 1024) return false;
+
+    board_size = static_cast<int>(header[1]);
+    hidden = static_cast<int>(header[2]);
+    output_bias = output[0];
+    output_divisor = output[1];
+    ft_bias.resize(hidden);
+    ft_weights.resize(static_cast<size_t>(board_size) * board_size * 2 * hidden);
+    out_weights.resize(2 * hidden);
+    return read_pod(in, ft_bias.data(), ft_bias.size())
+        && read_pod(in, ft_weights.data(), ft_weights.size())
+        && read_pod(in, out_weights.data(), out_weights.size());
+}
+
+bool NNUENetwork::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    uint32_t header[3] = {VERSION, static_cast<uint32_t>(board_size), static_cast<uint32_t>(hidden)};
+    int32_t output[2] = {output_bias, output_divisor};
+    write_pod(out, "GNUE", 4);
+    write_pod(out, header, 3);
+    write_pod(out, output, 2);
+    write_pod(out, ft_bias.data(), ft_bias.size());
+    write_pod(out, ft_weights.data(), ft_weights.size());
+    write_pod(out, out_weights.data(), out_weights.size());
+    return static_cast<bool>(out);
+}
+
+// --- ACCUMULATOR ---
+
+// Feature rows: cell idx seen from `perspective`, own stone first then opponent stone
+static inline size_t feature_row(int idx, int stone, int perspective) {
+    return static_cast<size_t>(idx) * 2 + (stone == perspective ? 0 : 1);
+}
+
+void NNUENetwork::refresh(const std::vector<int>& board, int16_t* acc) const {
+    std::copy(ft_bias.begin(), ft_bias.end(), acc);
+    std::copy(ft_bias.begin(), ft_bias.end(), acc + hidden);
+    for (int idx = 0; idx < static_cast<int>(board.size()); ++idx) {
+        if (board[idx] != 0) add_stone(acc, idx, board[idx]);
+    }
+}
+
+void NNUENetwork::add_stone(int16_t* acc, int idx, int player) const {
+    for (int persp = 1; persp <= 2; ++persp) {
+        int16_t* a = acc + (persp - 1) * hidden;
+        const int16_t* w = ft_weights.data() + feature_row(idx, player, persp) * hidden;
+        for (int i = 0; i < hidden; ++i) a[i] = static_cast<int16_t>(a[i] + w[i]);
+    }
+}
+
+void NNUENetwork::remove_stone(int16_t* acc, int idx, int player) const {
+    for (int persp = 1; persp <= 2; ++persp) {
+        int16_t* a = acc + (persp - 1) * hidden;
+        const int16_t* w = ft_weights.data() + feature_row(idx, player, persp) * hidden;
+        for (int i = 0; i < hidden; ++i) a[i] = static_cast<int16_t>(a[i] - w[i]);
+    }
+}
+
+// --- OUTPUT LAYER ---
+
+// sum(clamp(acc[i], 0, 127) * w[i]); n is a multiple of 32
+static int32_t clipped_dot(const int16_t* acc, const int8_t* w, int n) {
+#if defined(__AVX2__)
+    const __m256i max_act = _mm256_set1_epi8(127);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 16));
+        // packus interleaves 128-bit lanes; the permute restores element order
+        __m256i act = _mm256_permute4x64_epi64(_mm256_packus_epi16(a0, a1), 0xD8);
+        act = _mm256_min_epu8(act, max_act);
+        __m256i wv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(act, wv), ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) sum += std::clamp<int32_t>(acc[i], 0, 127) * w[i];
+    return sum;
+#endif
+}
+
+int NNUENetwork::evaluate(const int16_t* acc, int player) const {
+    const int16_t* us = acc + (player - 1) * hidden;
+    const int16_t* them = acc + (2 - player) * hidden;
+    int32_t sum = output_bias
+                + clipped_dot(us, out_weights.data(), hidden)
+                + clipped_dot(them, out_weights.data() + hidden, hidden);
+    return sum / output_divisor;
+}
+
+// --- GLOBAL NETWORK ---
+
+bool load_nnue(const std::string& path) {
+    auto net = std::make_unique<NNUENetwork>();
+    if (!net->load(path)) return false;
+    loaded_net = std::move(net);
+    return true;
+}
+
+const NNUENetwork* active_nnue(int width, int height) {
+    if (!loaded_net || width != loaded_net->board_size || height != loaded_net->board_size) return nullptr;
+    return loaded_net.get();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small quantized network: one accumulator layer per perspective, fed by
+// "stone of mine / stone of theirs at cell i" features, then a clipped-ReLU
+// output layer. The accumulator is updated one weight column per stone.
+//
+// File layout (little endian):
+//   char[4] "GNUE", u32 version (1), u32 board_size, u32 hidden,
+//   i32 output_bias, i32 output_divisor,
+//   i16 ft_bias[hidden], i16 ft_weights[board_size^2 * 2][hidden],
+//   i8  out_weights[2 * hidden]   (side to move first, then opponent)
+struct NNUENetwork {
+    static constexpr uint32_t VERSION = 1;
+
+    int board_size = 0;
+    int hidden = 0; // multiple of 32
+    int32_t output_bias = 0;
+    int32_t output_divisor = 1;
+    std::vector<int16_t> ft_bias;
+    std::vector<int16_t> ft_weights;
+    std::vector<int8_t> out_weights;
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // acc holds 2 * hidden values: player 1's perspective, then player 2's
+    void refresh(const std::vector<int>& board, int16_t* acc) const;
+    void add_stone(int16_t* acc, int idx, int player) const;
+    void remove_stone(int16_t* acc, int idx, int player) const;
+    int evaluate(const int16_t* acc, int player) const;
+};
+
+// Network used by every GomokuAI whose board size it was trained for
+bool load_nnue(const std::string& path);
+const NNUENetwork* active_nnue(int width, int height);
@@ -0,0 +1,71 @@
+#include "Perft.hpp"
+#include "Search.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static void perft_node(GomokuAI& ai, int depth, int player, int ply, PerftResult& r) {
+    ++r.nodes;
+    if (depth == 0) {
+        ++r.leaves;
+        return;
+    }
+    auto moves = get_sorted_moves(ai, player, ply);
+    if (moves.empty()) {
+        ++r.leaves;
+        return;
+    }
+    for (const auto& mv : moves) {
+        ai.make_move(mv.second, player);
+        if (check_win(ai.board, mv.second, ai.width, ai.height, player)) {
+            ++r.nodes;
+            ++r.leaves;
+        } else {
+            perft_node(ai, depth - 1, 3 - player, ply + 1, r);
+        }
+        ai.unmake_move();
+    }
+}
+
+PerftResult perft(const GomokuAI& ai, int depth, int player, int threads) {
+    auto start = std::chrono::steady_clock::now();
+    PerftResult total;
+    GomokuAI root = ai;
+    root.clear_history();
+    if (depth <= 0 || threads <= 1) {
+        perft_node(root, depth, player, 0, total);
+    } else {
+        auto moves = get_sorted_moves(root, player, 0);
+        total.nodes = 1;
+        if (moves.empty()) total.leaves = 1;
+
+        std::atomic<size_t> next(0);
+        std::mutex lock;
+        auto worker = [&]() {
+            GomokuAI local = ai; // each worker owns a board copy
+            local.clear_history();
+            PerftResult r;
+            for (size_t i; (i = next++) < moves.size();) {
+                int idx = moves[i].second;
+                local.make_move(idx, player);
+                if (check_win(local.board, idx, local.width, local.height, player)) {
+                    ++r.nodes;
+                    ++r.leaves;
+                } else {
+                    perft_node(local, depth - 1, 3 - player, 1, r);
+                }
+                local.unmake_move();
+            }
+            std::lock_guard<std::mutex> hold(lock);
+            total.nodes += r.nodes;
+            total.leaves += r.leaves;
+        };
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+        for (auto& th : pool) th.join();
+    }
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
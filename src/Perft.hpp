@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include "GomokuAI.hpp"
+
+// Counts of a perft run
+struct PerftResult {
+    uint64_t leaves = 0; // positions at the full depth, plus lines ended early
+    uint64_t nodes = 0;  // every position visited, the root included
+    double seconds = 0;
+};
+
+// Enumerates the candidate tree of the move generator (the moves
+// get_sorted_moves returns) with make_move/unmake_move, `player` moving
+// first, down to `depth` plies. A move completing five, or a position without
+// candidates, ends its line. Nothing is evaluated or pruned, so the node rate
+// is the throughput of the board core, and the counts only change when the
+// generator or the board updates do. With threads > 1 the root moves are
+// shared out between threads, each on its own board copy. Move ordering
+// tables of the calling thread are cleared.
+PerftResult perft(const GomokuAI& ai, int depth, int player = 1, int threads = 1);
@@ -1,130 +1,480 @@
 #include "Protocol.hpp"
-#include <iostream>
-#include <sstream>
-#include <unordered_map>
-#include <functional>
+#include "Perft.hpp"
+#include "ProvenResults.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
 
-Protocol::Protocol() : should_stop(false) {}
+// Splits the next space-separated token off the front of `s`
+static std::string_view next_token(std::string_view& s) {
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string_view::npos) {
+        s = {};
+        return {};
+    }
+    s.remove_prefix(b);
+    size_t e = std::min(s.find_first_of(" \t"), s.size());
+    std::string_view tok = s.substr(0, e);
+    s.remove_prefix(e);
+    return tok;
+}
+
+static bool parse_int(std::string_view s, int& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+static bool parse_u64(std::string_view s, uint64_t& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+// "alphabeta" or "mcts"
+static bool parse_backend(std::string_view s, SearchBackend& out) {
+    if (s == "alphabeta") out = SearchBackend::AlphaBeta;
+    else if (s == "mcts") out = SearchBackend::MCTS;
+    else return false;
+    return true;
+}
+
+// Player names in the game file
+constexpr const char* BRAIN_NAME = "pbrain-gomoku-ai";
+constexpr const char* OPPONENT_NAME = "opponent";
+
+// Margins of a timed turn, in milliseconds before its limit. The move is sent
+// reply_margin_ms (INFO reply_margin) early, which covers the pipe and the
+// manager's scheduling; before that the search is stopped early enough for
+// twice the slowest recent abort to fit, and at least MIN_ABORT_MARGIN_MS.
+constexpr int DEFAULT_REPLY_MARGIN_MS = 50;
+constexpr int MIN_ABORT_MARGIN_MS = 20;
+constexpr int INITIAL_ABORT_LATENCY_MS = 10;
+
+Protocol::Protocol(int in_fd, int out_fd)
+    : should_stop(false), in_fd(in_fd), out_fd(out_fd), reply_margin_ms(DEFAULT_REPLY_MARGIN_MS),
+      abort_latency_ms(INITIAL_ABORT_LATENCY_MS) {}
+
+Protocol::~Protocol() {
+    if (search_thread.joinable()) {
+        ai.stop_search();
+        finish_search();
+    }
+}
+
+bool Protocol::record_session(const std::string& path) {
+    return session.open(path);
+}
+
+bool Protocol::record_games(const std::string& path) {
+    return games.open(path);
+}
+
+// Adds a stone placed on an empty cell to the game record
+void Protocol::note_move(int x, int y, int player) {
+    if (x < 0 || x >= ai.width || y < 0 || y >= ai.height || ai.board[y * ai.width + x] != 0) return;
+    if (game_moves.empty()) game_first = player;
+    game_moves.push_back(static_cast<uint16_t>(y * ai.width + x));
+}
+
+// Appends the game so far to the game file, with absolute colors: the side
+// that moved first is player 1. A five on the last move decides the result.
+void Protocol::save_game() {
+    if (!games.is_open() || game_moves.empty()) return;
+    GameRecord g;
+    g.board_size = ai.width;
+    g.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    g.first = game_first == 1 ? BRAIN_NAME : OPPONENT_NAME;
+    g.second = game_first == 1 ? OPPONENT_NAME : BRAIN_NAME;
+    int last = game_moves.back();
+    if (ai.is_five(last)) g.result = static_cast<int8_t>(ai.board[last] == game_first ? 1 : 2);
+    g.moves = game_moves;
+    if (!games.append(g)) send_log("DEBUG", "cannot append the game to the game file");
+    game_moves.clear();
+}
 
 void Protocol::run() {
-    std::cout.setf(std::ios::unitbuf); // Unbuffered output
-    for (std::string line; !should_stop && std::getline(std::cin, line);) {
-        // Remove potential carriage return
-        if (!line.empty() && line.back() == '\r') line.pop_back();
+    for (std::string_view line; !should_stop && read_line(line);) {
         if (line.empty()) continue;
         handle_command(line);
     }
+    finish_search();
 }
 
-void Protocol::send_log(const std::string_view& type, const std::string_view& msg) {
-    std::cout << type << " " << msg << std::endl;
+// Returns the next input line without its line ending. The view stays valid
+// until the following call.
+bool Protocol::read_line(std::string_view& line) {
+    for (;;) {
+        const char* begin = in_buf.data() + in_begin;
+        size_t avail = in_end - in_begin;
+        const char* nl = static_cast<const char*>(std::memchr(begin, '\n', avail));
+        if (nl || (in_eof && avail > 0) || (in_begin == 0 && in_end == in_buf.size())) {
+            // Complete line, last unterminated line, or a line longer than the buffer
+            size_t len = nl ? static_cast<size_t>(nl - begin) : avail;
+            in_begin += nl ? len + 1 : len;
+            line = std::string_view(begin, len);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (session.is_open()) session.input(line);
+            return true;
+        }
+        if (in_eof) return false;
+
+        if (in_begin > 0) {
+            std::memmove(in_buf.data(), begin, avail);
+            in_begin = 0;
+            in_end = avail;
+        }
+        ssize_t n = ::read(in_fd, in_buf.data() + in_end, in_buf.size() - in_end);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) in_eof = true;
+        else in_end += static_cast<size_t>(n);
+    }
 }
 
-void Protocol::handle_start(std::string& cmd) {
-    std::stringstream ss(cmd);
-    std::string temp;
+void Protocol::send(std::string_view msg) {
+    while (!msg.empty()) {
+        ssize_t n = ::write(out_fd, msg.data(), msg.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        msg.remove_prefix(static_cast<size_t>(n));
+    }
+}
+
+void Protocol::send_log(std::string_view type, std::string_view msg) {
+    char sep[] = " ";
+    char nl[] = "\n";
+    iovec iov[4] = {
+        {const_cast<char*>(type.data()), type.size()},
+        {sep, 1},
+        {const_cast<char*>(msg.data()), msg.size()},
+        {nl, 1},
+    };
+    size_t total = type.size() + msg.size() + 2;
+    ssize_t n;
+    do n = ::writev(out_fd, iov, 4);
+    while (n < 0 && errno == EINTR);
+    if (n < 0 || static_cast<size_t>(n) == total) return;
+
+    // Short write: finish the line piece by piece
+    size_t done = static_cast<size_t>(n);
+    for (const iovec& part : iov) {
+        std::string_view piece(static_cast<const char*>(part.iov_base), part.iov_len);
+        if (done >= piece.size()) {
+            done -= piece.size();
+            continue;
+        }
+        send(piece.substr(done));
+        done = 0;
+    }
+}
+
+// A turn takes an equal share of the match time over the moves still
+// expected: EXPECTED_GAME_MOVES of ours per game, never fewer than MIN_MOVES_TO_GO
+constexpr int EXPECTED_GAME_MOVES = 60;
+constexpr int MIN_MOVES_TO_GO = 15;
+
+int Protocol::turn_time_limit() const {
+    int limit = timeout_turn > 0 ? timeout_turn : 0;
+    if (time_left != 2147483647) {
+        int played = static_cast<int>(ai.stones().size()) / 2;
+        int share = time_left / std::max(MIN_MOVES_TO_GO, EXPECTED_GAME_MOVES - played);
+        limit = limit > 0 ? std::min(limit, share) : share;
+        limit = std::max(limit, 1);
+    }
+    return limit;
+}
+
+Point Protocol::think(const SearchLimits& turn_limits) {
+    return ai.find_best_move(turn_limits);
+}
+
+// Starts searching in the background; the move is sent when the search
+// returns, or by the watchdog if it overruns a timed turn
+void Protocol::play_move() {
+    using Clock = std::chrono::steady_clock;
+    // The manager's clock has run since the command arrived, including any
+    // wait for an overrunning search of the previous turn
+    Clock::time_point start = command_time != Clock::time_point() ? command_time : Clock::now();
+    command_time = Clock::time_point();
+    finish_search();
+    ai.clear_stop();
+    replied = false;
+    SearchLimits turn_limits = limits;
+    int budget = turn_time_limit();
+    Clock::time_point stop_at = Clock::time_point::max();
+    if (budget > 0) {
+        // Tiny budgets keep at least a quarter of the turn for the search
+        int reply_margin = std::min(reply_margin_ms, budget / 4);
+        int abort_margin = std::min(std::max(MIN_ABORT_MARGIN_MS, 2 * abort_latency_ms), budget / 2);
+        stop_at = start + std::chrono::milliseconds(budget - reply_margin - abort_margin);
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(stop_at - Clock::now()).count();
+        turn_limits.max_time = static_cast<int>(std::max<int64_t>(1, left));
+        watchdog = std::thread(&Protocol::watch, this, stop_at, start + std::chrono::milliseconds(budget - reply_margin));
+    }
+    search_thread = std::thread([this, turn_limits, budget, start, stop_at] {
+        Point p = think(turn_limits);
+        Clock::time_point done = Clock::now();
+        bool by_watchdog;
+        {
+            std::lock_guard<std::mutex> hold(reply_lock);
+            by_watchdog = replied;
+            if (!replied) {
+                replied = true;
+                reply = p;
+                if (ai.get_multipv() > 1) send_lines();
+                send_move(p);
+                reply_time = Clock::now();
+            }
+            p = reply;
+        }
+        reply_cv.notify_all();
+        if (done > stop_at) {
+            // Stopped by the clock: how long the abort took, remembered with a slow decay
+            int late = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(done - stop_at).count());
+            abort_latency_ms = std::max(late, abort_latency_ms * 3 / 4);
+        }
+        note_move(p.x, p.y, 1);
+        ai.update_board(p.x, p.y, 1); // 1 is us
+
+        if (session.is_open()) {
+            auto us = [start](Clock::time_point t) {
+                return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(t - start).count());
+            };
+            const SearchStats& stats = ai.last_search();
+            session.turn({p, stats.score, stats.depth, stats.nodes, budget, us(done), us(reply_time), by_watchdog});
+        }
+    });
+}
+
+// Watchdog of a timed turn: stops the search at `stop_at`, and replies in its
+// place at `reply_by` if it has not returned by then
+void Protocol::watch(std::chrono::steady_clock::time_point stop_at, std::chrono::steady_clock::time_point reply_by) {
+    std::unique_lock<std::mutex> hold(reply_lock);
+    if (reply_cv.wait_until(hold, stop_at, [this] { return replied; })) return;
+    ai.stop_search();
+    if (reply_cv.wait_until(hold, reply_by, [this] { return replied; })) return;
+    Point p = ai.best_move_so_far();
+    if (p.x < 0) return; // no move yet: only the search can answer
+    replied = true;
+    reply = p;
+    send_move(p);
+    reply_time = std::chrono::steady_clock::now();
+    send_log("DEBUG", "search overran the turn; sent its best move so far");
+}
+
+// "x,y" of our move
+void Protocol::send_move(Point p) {
+    // Each int takes at most 11 characters
+    char buf[32];
+    char* end = std::to_chars(buf, buf + 11, p.x).ptr;
+    *end++ = ',';
+    end = std::to_chars(end, end + 11, p.y).ptr;
+    *end++ = '\n';
+    send(std::string_view(buf, static_cast<size_t>(end - buf)));
+}
+
+// One "MESSAGE pv <k> score <s> depth <d> x,y x,y ..." line per multi-PV line
+void Protocol::send_lines() {
+    const auto& lines = ai.last_lines();
+    for (size_t k = 0; k < lines.size(); ++k) {
+        char buf[1024];
+        char* const limit = buf + sizeof(buf);
+        char* end = buf;
+        auto put = [&](std::string_view text) {
+            end = std::copy(text.begin(), text.end(), end);
+        };
+        put("pv ");
+        end = std::to_chars(end, end + 11, static_cast<int>(k + 1)).ptr;
+        put(" score ");
+        end = std::to_chars(end, end + 11, lines[k].score).ptr;
+        put(" depth ");
+        end = std::to_chars(end, end + 11, ai.last_search().depth).ptr;
+        for (const Point& m : lines[k].pv) {
+            if (limit - end < 24) break;
+            *end++ = ' ';
+            end = std::to_chars(end, end + 11, m.x).ptr;
+            *end++ = ',';
+            end = std::to_chars(end, end + 11, m.y).ptr;
+        }
+        send_log("MESSAGE", std::string_view(buf, static_cast<size_t>(end - buf)));
+    }
+}
+
+void Protocol::finish_search() {
+    if (search_thread.joinable()) search_thread.join();
+    if (watchdog.joinable()) watchdog.join();
+}
+
+void Protocol::handle_start(std::string_view cmd) {
+    next_token(cmd); // START
     int size;
-    ss >> temp >> size;
-    if (ss.fail()) size = 20;
-    if (size < 5) {
+    if (!parse_int(next_token(cmd), size)) size = 20;
+    if (size < 5 || size > MAX_BOARD_SIZE) {
         send_log("ERROR", "unsupported size");
         return;
     }
+    // Extension: START <size> mcts|alphabeta also picks the search backend
+    SearchBackend backend;
+    if (parse_backend(next_token(cmd), backend)) ai.set_backend(backend);
     ai.init(size);
-    std::cout << "OK" << std::endl;
+    game_moves.clear();
+    send("OK\n");
 }
 
-void Protocol::handle_turn(std::string& cmd) {
-    std::stringstream ss(cmd);
-    std::string temp, coords;
-    ss >> temp >> coords;
-
-    Point opp = ai.parse_coordinates(coords);
+void Protocol::handle_turn(std::string_view cmd) {
+    next_token(cmd); // TURN
+    Point opp = ai.parse_coordinates(next_token(cmd));
     if (opp.x != -1) {
+        note_move(opp.x, opp.y, 2);
         ai.update_board(opp.x, opp.y, 2); // 2 is opponent
     }
-
-    int limit = timeout_turn;
-    if (time_left < limit) limit = time_left;
-    Point p = ai.find_best_move(limit);
-    ai.update_board(p.x, p.y, 1); // 1 is us // 1 is us
-    std::cout << p.x << "," << p.y << std::endl;
+    play_move();
 }
 
-void Protocol::handle_begin([[maybe_unused]] std::string& cmd) {
-    int limit = timeout_turn;
-    if (time_left < limit) limit = time_left;
-    Point p = ai.find_best_move(limit);
-    ai.update_board(p.x, p.y, 1); // 1 is us
-    std::cout << p.x << "," << p.y << std::endl;
+void Protocol::handle_begin([[maybe_unused]] std::string_view cmd) {
+    play_move();
 }
 
-void Protocol::handle_board([[maybe_unused]] std::string& cmd) {
-    ai.init(ai.width); // Clear board
-    std::string entry;
-    while (std::getline(std::cin, entry)) {
-        if (!entry.empty() && entry.back() == '\r') entry.pop_back();
+void Protocol::handle_board([[maybe_unused]] std::string_view cmd) {
+    // The manager's position replaces ours, but only the stones that differ
+    // are applied so the search tables survive a resend of the same game.
+    std::vector<int> target(static_cast<size_t>(ai.width * ai.height), 0);
+    // The manager lists the stones in the order they were played
+    game_moves.clear();
+    for (std::string_view entry; read_line(entry);) {
         if (entry == "DONE") break;
 
         size_t c1 = entry.find(',');
         size_t c2 = entry.find(',', c1 + 1);
-        if (c1 != std::string::npos && c2 != std::string::npos) {
-            try {
-                int x = std::stoi(entry.substr(0, c1));
-                int y = std::stoi(entry.substr(c1 + 1, c2 - c1 - 1));
-                int player = std::stoi(entry.substr(c2 + 1));
-                ai.update_board(x, y, player);
-            } catch (...) {}
+        if (c1 == std::string_view::npos || c2 == std::string_view::npos) continue;
+        int x, y, player;
+        if (!parse_int(entry.substr(0, c1), x) ||
+            !parse_int(entry.substr(c1 + 1, c2 - c1 - 1), y) ||
+            !parse_int(entry.substr(c2 + 1), player)) {
+            continue;
+        }
+        if (x < 0 || x >= ai.width || y < 0 || y >= ai.height || (player != 1 && player != 2) ||
+            target[y * ai.width + x] != 0) {
+            send_log("DEBUG", "BOARD: ignored invalid or duplicate stone");
+            continue;
         }
+        if (game_moves.empty()) game_first = player;
+        game_moves.push_back(static_cast<uint16_t>(y * ai.width + x));
+        target[y * ai.width + x] = player;
     }
-    int limit = timeout_turn;
-    if (time_left < limit) limit = time_left;
-    Point p = ai.find_best_move(limit);
-    ai.update_board(p.x, p.y, 1); // 1 is us
-    std::cout << p.x << "," << p.y << std::endl;
-}
-
-void Protocol::handle_info(std::string& cmd) {
-    std::stringstream ss(cmd);
-    std::string temp, key;
-    ss >> temp; // INFO
-    while (ss >> key) {
-        if (key == "timeout_turn") {
-            int val;
-            ss >> val;
-            if (!ss.fail()) timeout_turn = val;
-        } else if (key == "timeout_match") {
-            int val;
-            ss >> val;
-            if (!ss.fail()) timeout_match = val;
-        } else if (key == "time_left") {
-             int val;
-            ss >> val;
-            if (!ss.fail()) {
-                time_left = val;
+    ai.sync_board(target);
+    play_move();
+}
+
+void Protocol::handle_info(std::string_view cmd) {
+    next_token(cmd); // INFO
+    for (std::string_view key; !(key = next_token(cmd)).empty();) {
+        std::string_view value = next_token(cmd);
+        if (key == "folder") {
+            // The manager's folder for files kept between games
+            if (!value.empty()) {
+                load_proven(std::string(value) + "/gomoku.proven");
+                games.open(std::string(value) + "/gomoku.games");
             }
-        } else {
-             std::string val;
-             ss >> val; // consume value
+            continue;
+        }
+        if (key == "max_memory") {
+            // In KB, as in the manager's config; 0: no limit
+            uint64_t kb;
+            if (parse_u64(value, kb) && kb <= SIZE_MAX / 1024) ai.set_memory_limit(static_cast<size_t>(kb * 1024));
+            continue;
+        }
+        if (key == "max_nodes") {
+            // Node budgets go well past 2^31; 0: no limit
+            uint64_t nodes;
+            if (parse_u64(value, nodes)) limits.max_nodes = nodes;
+            continue;
         }
+        if (key == "search") {
+            SearchBackend backend;
+            if (parse_backend(value, backend)) ai.set_backend(backend);
+            continue;
+        }
+        int val;
+        if (!parse_int(value, val)) continue;
+        if (key == "timeout_turn") timeout_turn = val;
+        else if (key == "timeout_match") timeout_match = val;
+        else if (key == "time_left") time_left = val;
+        else if (key == "threads") ai.set_threads(val);
+        else if (key == "max_depth") limits.max_depth = std::max(0, val);
+        else if (key == "multipv") ai.set_multipv(val);
+        else if (key == "extensions") ai.set_extensions(static_cast<unsigned>(std::max(0, val)));
+        else if (key == "reply_margin") reply_margin_ms = std::max(0, val);
     }
 }
 
-void Protocol::handle_end([[maybe_unused]] std::string& cmd) {
+void Protocol::handle_end([[maybe_unused]] std::string_view cmd) {
+    save_game();
+    save_proven();
     should_stop = true;
 }
 
-void Protocol::handle_about([[maybe_unused]] std::string& cmd) {
-    std::cout << "name=\"pbrain-gomoku-ai\", version=\"1.0\", author=\"Mael-Tristan\", country=\"FR\"" << std::endl;
+// Nothing left to do: handle_command already cut the search short
+void Protocol::handle_stop([[maybe_unused]] std::string_view cmd) {}
+
+// Extension: PERFT <depth> [threads] enumerates the move generator's tree
+// from the current position, us to move, and reports counts and speed
+void Protocol::handle_perft(std::string_view cmd) {
+    next_token(cmd); // PERFT
+    int depth, threads;
+    if (!parse_int(next_token(cmd), depth) || depth < 0) {
+        send_log("ERROR", "PERFT needs a depth");
+        return;
+    }
+    if (!parse_int(next_token(cmd), threads) || threads < 1) threads = 1;
+
+    PerftResult r = perft(ai, depth, 1, threads);
+    uint64_t ms = static_cast<uint64_t>(r.seconds * 1000);
+    uint64_t nps = r.seconds > 0 ? static_cast<uint64_t>(r.nodes / r.seconds) : 0;
+    char buf[160];
+    char* end = buf;
+    auto put = [&](std::string_view text) {
+        end = std::copy(text.begin(), text.end(), end);
+    };
+    put("perft depth ");
+    end = std::to_chars(end, end + 11, depth).ptr;
+    put(" leaves ");
+    end = std::to_chars(end, end + 20, r.leaves).ptr;
+    put(" nodes ");
+    end = std::to_chars(end, end + 20, r.nodes).ptr;
+    put(" time ");
+    end = std::to_chars(end, end + 20, ms).ptr;
+    put(" nps ");
+    end = std::to_chars(end, end + 20, nps).ptr;
+    send_log("MESSAGE", std::string_view(buf, static_cast<size_t>(end - buf)));
 }
 
-void Protocol::handle_command(std::string& cmd) {
+void Protocol::handle_about([[maybe_unused]] std::string_view cmd) {
+    send("name=\"pbrain-gomoku-ai\", version=\"1.0\", author=\"Mael-Tristan\", country=\"FR\"\n");
+}
+
+void Protocol::handle_command(std::string_view cmd) {
+    command_time = std::chrono::steady_clock::now();
+    // STOP and END cut the search short (it still replies with its best move so far);
+    // any other command waits for the reply so piped input keeps its full think time.
+    if (search_thread.joinable()) {
+        if (cmd.rfind("STOP", 0) == 0 || cmd.rfind("END", 0) == 0) ai.stop_search();
+        finish_search();
+    }
+
     if (cmd.rfind("START", 0) == 0) handle_start(cmd);
     else if (cmd.rfind("TURN", 0) == 0) handle_turn(cmd);
     else if (cmd.rfind("BEGIN", 0) == 0) handle_begin(cmd);
     else if (cmd.rfind("BOARD", 0) == 0) handle_board(cmd);
     else if (cmd.rfind("INFO", 0) == 0) handle_info(cmd);
     else if (cmd.rfind("END", 0) == 0) handle_end(cmd);
+    else if (cmd.rfind("STOP", 0) == 0) handle_stop(cmd);
     else if (cmd.rfind("ABOUT", 0) == 0) handle_about(cmd);
+    else if (cmd.rfind("PERFT", 0) == 0) handle_perft(cmd);
     else send_log("UNKNOWN", "command not implemented");
 }
@@ -1,33 +1,104 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
+#include "GameDB.hpp"
 #include "GomokuAI.hpp"
+#include "Session.hpp"
 
 class Protocol {
 public:
-    Protocol();
+    explicit Protocol(int in_fd = 0, int out_fd = 1);
+    virtual ~Protocol();
     void run();
+    // Records every input line and the stats of every turn to `path` (see Session.hpp)
+    bool record_session(const std::string& path);
+    // Appends every game to the game file at `path` when it ends (see GameDB.hpp)
+    bool record_games(const std::string& path);
 
 protected:
     GomokuAI ai;
 
-    void handle_start(std::string& cmd);
-    void handle_turn(std::string& cmd);
-    void handle_begin(std::string& cmd);
-    void handle_about(std::string& cmd);
+    void handle_start(std::string_view cmd);
+    void handle_turn(std::string_view cmd);
+    void handle_begin(std::string_view cmd);
+    void handle_about(std::string_view cmd);
+
+    // Waits for the in-flight search (if any) to reply
+    void finish_search();
+    // Milliseconds for the next turn, 0 when neither limit is set (think until stopped)
+    int turn_time_limit() const;
+    // The search of one turn, run on the search thread
+    virtual Point think(const SearchLimits& turn_limits);
+    // Depth and node limits from INFO
+    const SearchLimits& search_limits() const { return limits; }
 
 private:
     bool should_stop;
     int timeout_turn = 1000;
     int timeout_match = 100000;
     int time_left = 2147483647;
+    SearchLimits limits; // depth/node limits from INFO; the time limit is set per turn
+
+    // Input is read straight from in_fd into a fixed buffer; lines are views into it
+    int in_fd;
+    int out_fd;
+    std::array<char, 1 << 16> in_buf;
+    size_t in_begin = 0;
+    size_t in_end = 0;
+    bool in_eof = false;
+
+    // Searches run here so commands can still be read while thinking
+    std::thread search_thread;
+
+    // A timed turn also runs a watchdog: it stops the search ahead of the
+    // deadline and, if the search still has not returned just before it,
+    // sends the search's best move so far itself. Whichever thread takes
+    // `replied` under reply_lock sends the move; the search thread always
+    // plays `reply` on the board.
+    std::thread watchdog;
+    std::mutex reply_lock;
+    std::condition_variable reply_cv;
+    bool replied = false;
+    Point reply{-1, -1};
+    std::chrono::steady_clock::time_point reply_time;
+    // When the command being handled was read; a turn's time counts from it
+    std::chrono::steady_clock::time_point command_time;
+    // The move is sent this many ms before the turn's limit
+    int reply_margin_ms;
+    // Longest recent delay between the stop and the search returning, in ms
+    int abort_latency_ms;
+
+    SessionWriter session;
+
+    // Moves of the current game in play order, and who made the first one
+    // (1: us, 2: the opponent); appended to `games` at END
+    GameWriter games;
+    std::vector<uint16_t> game_moves;
+    int game_first = 0;
+    void note_move(int x, int y, int player);
+    void save_game();
+
+    bool read_line(std::string_view& line);
 
-    void handle_command(std::string& cmd);
+    void handle_command(std::string_view cmd);
 
-    void handle_board(std::string& cmd);
-    void handle_info(std::string& cmd);
-    void handle_end(std::string& cmd);
+    void handle_board(std::string_view cmd);
+    void handle_info(std::string_view cmd);
+    void handle_end(std::string_view cmd);
+    void handle_stop(std::string_view cmd);
+    void handle_perft(std::string_view cmd);
 
-    void send_log(const std::string_view& type, const std::string_view& msg);
+    void play_move();
+    void watch(std::chrono::steady_clock::time_point stop_at, std::chrono::steady_clock::time_point reply_by);
+    void send_move(Point p);
+    void send_lines();
+    void send(std::string_view msg);
+    void send_log(std::string_view type, std::string_view msg);
 };
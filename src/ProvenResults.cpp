@@ -0,0 +1,133 @@
+#include "ProvenResults.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t PROVEN_VERSION = 1;
+static constexpr size_t PROVEN_HEADER = 16;
+
+static ProvenResults store_instance;
+static std::string store_path;
+
+ProvenResults::~ProvenResults() {
+    unmap();
+}
+
+void ProvenResults::unmap() {
+    if (map) munmap(map, map_size);
+    map = nullptr;
+    map_size = 0;
+    mapped = nullptr;
+    mapped_count = 0;
+}
+
+bool ProvenResults::load(const std::string& path) {
+    unmap();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= PROVEN_HEADER) {
+        map_size = static_cast<size_t>(st.st_size);
+        map = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) map = nullptr;
+    }
+    ::close(fd);
+    if (!map) return false;
+
+    const char* data = static_cast<const char*>(map);
+    uint32_t version;
+    uint64_t count;
+    std::memcpy(&version, data + 4, 4);
+    std::memcpy(&count, data + 8, 8);
+    if (std::memcmp(data, "GPRV", 4) != 0 || version != PROVEN_VERSION ||
+        count != (map_size - PROVEN_HEADER) / sizeof(ProvenEntry) ||
+        map_size != PROVEN_HEADER + count * sizeof(ProvenEntry)) {
+        unmap();
+        return false;
+    }
+    mapped = reinterpret_cast<const ProvenEntry*>(data + PROVEN_HEADER);
+    mapped_count = count;
+    return true;
+}
+
+// Merges the mapped and added entries into a new sorted file; added entries
+// replace mapped ones with the same key
+bool ProvenResults::save(const std::string& path) {
+    std::vector<ProvenEntry> fresh;
+    fresh.reserve(added.size());
+    for (const auto& kv : added) fresh.push_back(kv.second);
+    auto by_key = [](const ProvenEntry& a, const ProvenEntry& b) { return a.key < b.key; };
+    std::sort(fresh.begin(), fresh.end(), by_key);
+
+    std::vector<ProvenEntry> merged;
+    merged.reserve(mapped_count + fresh.size());
+    size_t i = 0;
+    for (const ProvenEntry& e : fresh) {
+        for (; i < mapped_count && mapped[i].key < e.key; ++i) merged.push_back(mapped[i]);
+        if (i < mapped_count && mapped[i].key == e.key) ++i;
+        merged.push_back(e);
+    }
+    merged.insert(merged.end(), mapped + i, mapped + mapped_count);
+
+    std::string tmp = path + ".tmp";
+    std::FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (!out) return false;
+    uint64_t count = merged.size();
+    std::fwrite("GPRV", 1, 4, out);
+    std::fwrite(&PROVEN_VERSION, sizeof(PROVEN_VERSION), 1, out);
+    std::fwrite(&count, sizeof(count), 1, out);
+    std::fwrite(merged.data(), sizeof(ProvenEntry), merged.size(), out);
+    bool ok = std::ferror(out) == 0;
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    added.clear();
+    return load(path);
+}
+
+bool ProvenResults::probe(uint64_t key, ProvenEntry& out) const {
+    auto it = added.find(key);
+    if (it != added.end()) {
+        out = it->second;
+        return true;
+    }
+    const ProvenEntry* end = mapped + mapped_count;
+    const ProvenEntry* e = std::lower_bound(mapped, end, key,
+                                            [](const ProvenEntry& a, uint64_t k) { return a.key < k; });
+    if (e == end || e->key != key) return false;
+    out = *e;
+    return true;
+}
+
+void ProvenResults::store(uint64_t key, int score, int move) {
+    if (size() >= MAX_ENTRIES) return;
+    added[key] = {key, score, static_cast<int16_t>(move), 0};
+}
+
+uint64_t ProvenResults::key_for(uint64_t hash_key, int board_size) {
+    // Zobrist keys only depend on the cell index, so boards of different sizes need a salt
+    return hash_key ^ (0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(board_size));
+}
+
+// --- GLOBAL STORE ---
+
+ProvenResults& proven_results() {
+    return store_instance;
+}
+
+bool load_proven(const std::string& path) {
+    store_path = path;
+    return store_instance.load(path);
+}
+
+bool save_proven() {
+    if (store_path.empty() || !store_instance.dirty()) return true;
+    return store_instance.save(store_path);
+}
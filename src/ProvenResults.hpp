@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// A root position whose outcome the search proved (forced win or forced loss
+// within the search horizon), with the move it chose there.
+struct ProvenEntry {
+    uint64_t key;  // GomokuAI::get_hash_key() salted with the board size
+    int32_t score; // mate score for the side to move
+    int16_t move;  // cell index
+    uint16_t reserved;
+};
+
+// Proven results that outlive init(): the entries saved by earlier games are
+// mmapped read-only from a sorted file, new ones are kept in memory until
+// save() merges both into the file again.
+//   char[4] "GPRV", u32 version, u64 count, ProvenEntry[count] sorted by key
+class ProvenResults {
+public:
+    ~ProvenResults();
+    bool load(const std::string& path);
+    bool save(const std::string& path);
+
+    bool probe(uint64_t key, ProvenEntry& out) const;
+    void store(uint64_t key, int score, int move);
+
+    size_t size() const { return mapped_count + added.size(); }
+    bool dirty() const { return !added.empty(); }
+
+    static uint64_t key_for(uint64_t hash_key, int board_size);
+
+private:
+    static constexpr size_t MAX_ENTRIES = 1 << 22;
+
+    void* map = nullptr;
+    size_t map_size = 0;
+    const ProvenEntry* mapped = nullptr;
+    size_t mapped_count = 0;
+    std::unordered_map<uint64_t, ProvenEntry> added;
+
+    void unmap();
+};
+
+// Process-wide store used by find_best_move, like the NNUE network.
+// load_proven() maps `path` and remembers it; save_proven() writes back there.
+// Only touched from the search thread, or while no search runs.
+ProvenResults& proven_results();
+bool load_proven(const std::string& path);
+bool save_proven();
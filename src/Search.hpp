@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "GomokuAI.hpp"
+
+// Alpha-beta internals of GomokuAI.cpp that the other search backends and
+// the kernel microbenchmarks build on. The search routines act on the search
+// find_best_move started: its limits, stop flag, shared tables and the
+// calling thread's node counter.
+
+constexpr int INF = 1000000000;
+constexpr int SCORE_WIN = 100000000;
+constexpr int TIMEOUT_SCORE = -2000000000; // Sentinel value
+// Static evaluations stay below the band of won/lost scores, which only
+// come from a five on the board and are kept as proven results
+constexpr int MAX_EVAL = SCORE_WIN - 1001;
+// Search depths are in fractions of a ply so extensions can add less than one
+constexpr int ONE_PLY = 4;
+
+extern std::atomic<uint64_t> shared_nodes; // nodes flushed by the search threads
+extern std::atomic<bool> time_out_flag;
+extern thread_local uint64_t nodes_visited; // the calling thread's, not yet flushed
+
+// Counts a node; true once the search has to stop
+bool check_time();
+// Adds the calling thread's count to shared_nodes
+void flush_nodes();
+bool check_win(const std::vector<int>& board, int idx, int w, int h, int player);
+
+// Hand-tuned evaluation for `player`, summed over every line of stones and
+// clamped to MAX_EVAL
+int eval_state(const GomokuAI& ai, int player);
+// Board-only part of score_move: centrality and the lines playing idx makes
+int tactical_score(const GomokuAI& ai, int idx, int player);
+// Move ordering score: the engine's killers and history, then tactics
+int score_move(const GomokuAI& ai, int idx, int player, int ply);
+
+// {score, idx} of the candidate moves, best first
+std::vector<std::pair<int, int>> get_sorted_moves(const GomokuAI& ai, int player, int ply, int best_tt_move = -1,
+                                                  const std::vector<int>& only = {});
+// Moves that answer the opponent's threats, or empty in a quiet position
+std::vector<int> forced_replies(const GomokuAI& ai, int player);
+// Score for `player` to move; TIMEOUT_SCORE when the search had to stop
+int negamax(GomokuAI& ai, int depth, int alpha, int beta, int player, int ply, int extended = 0,
+            int excluded = -1);
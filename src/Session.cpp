@@ -0,0 +1,135 @@
+#include "Session.hpp"
+#include <chrono>
+#include <cstring>
+
+static constexpr uint32_t SESSION_VERSION = 1;
+static constexpr size_t SESSION_HEADER = 16;
+static constexpr size_t RECORD_HEADER = 11;
+static constexpr size_t TURN_BYTES = 33;
+
+template <typename T>
+static void put(std::vector<uint8_t>& buf, T value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+static uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// --- WRITER ---
+
+SessionWriter::~SessionWriter() {
+    close();
+}
+
+bool SessionWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    start_ns = steady_ns();
+    uint64_t start_unix = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::fwrite("GSES", 1, 4, file);
+    std::fwrite(&SESSION_VERSION, sizeof(SESSION_VERSION), 1, file);
+    std::fwrite(&start_unix, sizeof(start_unix), 1, file);
+    return std::fflush(file) == 0;
+}
+
+uint64_t SessionWriter::now_us() const {
+    return (steady_ns() - start_ns) / 1000;
+}
+
+void SessionWriter::write(SessionRecord::Type type, const std::vector<uint8_t>& payload) {
+    buf.clear();
+    put<uint8_t>(buf, type);
+    put<uint64_t>(buf, now_us());
+    put<uint16_t>(buf, static_cast<uint16_t>(payload.size()));
+    buf.insert(buf.end(), payload.begin(), payload.end());
+    std::fwrite(buf.data(), 1, buf.size(), file);
+    std::fflush(file);
+}
+
+void SessionWriter::input(std::string_view line) {
+    std::lock_guard<std::mutex> hold(lock);
+    if (!file) return;
+    line = line.substr(0, 0xFFFF);
+    write(SessionRecord::INPUT, std::vector<uint8_t>(line.begin(), line.end()));
+}
+
+void SessionWriter::turn(const TurnRecord& t) {
+    std::lock_guard<std::mutex> hold(lock);
+    if (!file) return;
+    std::vector<uint8_t> payload;
+    put<int16_t>(payload, static_cast<int16_t>(t.move.x));
+    put<int16_t>(payload, static_cast<int16_t>(t.move.y));
+    put<int32_t>(payload, t.score);
+    put<int32_t>(payload, t.depth);
+    put<uint64_t>(payload, t.nodes);
+    put<int32_t>(payload, t.budget_ms);
+    put<uint32_t>(payload, t.think_us);
+    put<uint32_t>(payload, t.reply_us);
+    put<uint8_t>(payload, t.watchdog ? 1 : 0);
+    write(SessionRecord::TURN, payload);
+}
+
+bool SessionWriter::close() {
+    std::lock_guard<std::mutex> hold(lock);
+    if (!file) return true;
+    bool ok = std::ferror(file) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+// --- READER ---
+
+bool read_session(const std::string& path, std::vector<SessionRecord>& out, uint64_t* start_unix_us) {
+    out.clear();
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) return false;
+    std::vector<uint8_t> data;
+    uint8_t chunk[1 << 16];
+    for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), in)) > 0;) data.insert(data.end(), chunk, chunk + n);
+    std::fclose(in);
+    if (data.size() < SESSION_HEADER || std::memcmp(data.data(), "GSES", 4) != 0 ||
+        get<uint32_t>(data.data() + 4) != SESSION_VERSION) {
+        return false;
+    }
+    if (start_unix_us) *start_unix_us = get<uint64_t>(data.data() + 8);
+
+    for (size_t pos = SESSION_HEADER; pos + RECORD_HEADER <= data.size();) {
+        const uint8_t* p = data.data() + pos;
+        size_t bytes = get<uint16_t>(p + 9);
+        if (pos + RECORD_HEADER + bytes > data.size()) break; // torn last record
+        SessionRecord r;
+        r.type = static_cast<SessionRecord::Type>(p[0]);
+        r.time_us = get<uint64_t>(p + 1);
+        p += RECORD_HEADER;
+        pos += RECORD_HEADER + bytes;
+        if (r.type == SessionRecord::INPUT) {
+            r.line.assign(reinterpret_cast<const char*>(p), bytes);
+        } else if (r.type == SessionRecord::TURN && bytes == TURN_BYTES) {
+            r.turn.move = {get<int16_t>(p), get<int16_t>(p + 2)};
+            r.turn.score = get<int32_t>(p + 4);
+            r.turn.depth = get<int32_t>(p + 8);
+            r.turn.nodes = get<uint64_t>(p + 12);
+            r.turn.budget_ms = get<int32_t>(p + 20);
+            r.turn.think_us = get<uint32_t>(p + 24);
+            r.turn.reply_us = get<uint32_t>(p + 28);
+            r.turn.watchdog = p[32] & 1;
+        } else {
+            continue; // unknown record: skipped
+        }
+        out.push_back(std::move(r));
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GomokuAI.hpp"
+
+// One turn the brain played, as the protocol saw it
+struct TurnRecord {
+    Point move{-1, -1};
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int budget_ms = 0;       // time limit of the turn, 0: none
+    uint32_t think_us = 0;   // from the command to the search returning
+    uint32_t reply_us = 0;   // from the command to the move being sent
+    bool watchdog = false;   // the watchdog sent the move for an overrunning search
+};
+
+struct SessionRecord {
+    enum Type : uint8_t { INPUT = 1, TURN = 2 };
+    Type type = INPUT;
+    uint64_t time_us = 0; // since the session started
+    std::string line;     // INPUT
+    TurnRecord turn;      // TURN
+};
+
+// Session file, written as the session goes:
+//   char[4] "GSES", u32 version, u64 start (unix microseconds)
+//   then per record: u8 type, u64 time_us, u16 payload_bytes, payload
+//   INPUT payload: the line as read, without its line ending (at most 65535 bytes)
+//   TURN payload:  i16 x, i16 y, i32 score, i32 depth, u64 nodes, i32 budget_ms,
+//                  u32 think_us, u32 reply_us, u8 flags (1: watchdog)   (all little endian)
+// Each record is written with a single fwrite and flushed, so a crash can at
+// worst leave a truncated last record, which read_session ignores.
+class SessionWriter {
+public:
+    ~SessionWriter();
+    bool open(const std::string& path); // replaces an existing file
+    bool is_open() const { return file != nullptr; }
+    // Thread-safe
+    void input(std::string_view line);
+    void turn(const TurnRecord& t);
+    bool close();
+
+    // Microseconds since open()
+    uint64_t now_us() const;
+
+private:
+    std::FILE* file = nullptr;
+    uint64_t start_ns = 0; // steady clock at open()
+    std::mutex lock;
+    std::vector<uint8_t> buf;
+
+    void write(SessionRecord::Type type, const std::vector<uint8_t>& payload);
+};
+
+// Every complete record of the file at `path`; false if it cannot be read or
+// is not a session file
+bool read_session(const std::string& path, std::vector<SessionRecord>& out, uint64_t* start_unix_us = nullptr);
@@ -0,0 +1,124 @@
+#include "TrainingData.hpp"
+#include <cstring>
+
+static constexpr uint32_t TRAINING_VERSION = 1;
+
+template <typename T>
+static void put(std::FILE* f, T value) {
+    std::fwrite(&value, sizeof(T), 1, f);
+}
+
+template <typename T>
+static bool get(std::FILE* f, T& value) {
+    return std::fread(&value, sizeof(T), 1, f) == 1;
+}
+
+// --- WRITER ---
+
+TrainingWriter::~TrainingWriter() {
+    close();
+}
+
+bool TrainingWriter::open(const std::string& path, int board_size) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    std::fwrite("GTRD", 1, 4, file);
+    put<uint32_t>(file, TRAINING_VERSION);
+    put<uint32_t>(file, static_cast<uint32_t>(board_size));
+    return true;
+}
+
+void TrainingWriter::write(const TrainingRecord& r) {
+    put(file, r.key);
+    put(file, r.score);
+    put(file, r.best_move);
+    put(file, r.result);
+    put(file, r.depth);
+    put<uint16_t>(file, static_cast<uint16_t>(r.stones.size()));
+    std::fwrite(r.stones.data(), sizeof(uint16_t), r.stones.size(), file);
+}
+
+bool TrainingWriter::close() {
+    if (!file) return true;
+    bool ok = std::ferror(file) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+// --- READER ---
+
+TrainingReader::~TrainingReader() {
+    if (file) std::fclose(file);
+}
+
+bool TrainingReader::open(const std::string& path) {
+    if (file) std::fclose(file);
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    char magic[4];
+    uint32_t version, board_size;
+    if (std::fread(magic, 1, 4, file) != 4 || std::memcmp(magic, "GTRD", 4) != 0 ||
+        !get(file, version) || version != TRAINING_VERSION || !get(file, board_size)) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    size = static_cast<int>(board_size);
+    return true;
+}
+
+bool TrainingReader::next(TrainingRecord& r) {
+    uint16_t count;
+    if (!file || !get(file, r.key) || !get(file, r.score) || !get(file, r.best_move) ||
+        !get(file, r.result) || !get(file, r.depth) || !get(file, count)) {
+        return false;
+    }
+    r.stones.resize(count);
+    return std::fread(r.stones.data(), sizeof(uint16_t), count, file) == count;
+}
+
+// --- SYMMETRIES ---
+
+uint64_t record_key(const TrainingRecord& r, const GomokuAI& hasher) {
+    uint64_t key = 0;
+    for (uint16_t s : r.stones) {
+        int player = (s & TrainingRecord::OPPONENT_BIT) ? 2 : 1;
+        key ^= hasher.zobrist_at(s & ~TrainingRecord::OPPONENT_BIT, player);
+    }
+    return key;
+}
+
+int transform_cell(int idx, int size, int sym) {
+    int x = idx % size;
+    int y = idx / size;
+    int m = size - 1;
+    if (sym & 4) std::swap(x, y); // transpose
+    if (sym & 1) x = m - x;       // mirror
+    if (sym & 2) y = m - y;       // flip
+    return y * size + x;
+}
+
+TrainingRecord transform_record(const TrainingRecord& r, int size, int sym, const GomokuAI& hasher) {
+    TrainingRecord t = r;
+    for (uint16_t& s : t.stones) {
+        uint16_t side = s & TrainingRecord::OPPONENT_BIT;
+        s = static_cast<uint16_t>(transform_cell(s & ~TrainingRecord::OPPONENT_BIT, size, sym)) | side;
+    }
+    if (r.best_move >= 0) t.best_move = static_cast<int16_t>(transform_cell(r.best_move, size, sym));
+    t.key = record_key(t, hasher);
+    return t;
+}
+
+void play_record(GomokuAI& ai, const TrainingRecord& r) {
+    for (uint16_t s : r.stones) {
+        ai.make_move(s & ~TrainingRecord::OPPONENT_BIT, (s & TrainingRecord::OPPONENT_BIT) ? 2 : 1);
+    }
+}
+
+void take_back_record(GomokuAI& ai, const TrainingRecord& r) {
+    for (size_t i = 0; i < r.stones.size(); ++i) ai.unmake_move();
+}
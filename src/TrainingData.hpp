@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GomokuAI.hpp"
+
+// One labeled position. Stones are stored relative to the side to move, the
+// way GomokuAI searches them: own stones are player 1, opponent stones player 2.
+struct TrainingRecord {
+    uint64_t key = 0;    // Zobrist key of the position (GomokuAI::get_hash_key)
+    int32_t score = 0;   // search score for the side to move
+    int16_t best_move = -1;
+    int8_t result = 0;   // game result for the side to move: 1 win, 0 draw, -1 loss
+    uint8_t depth = 0;   // depth behind score, 0 when the tactical pre-pass decided
+    std::vector<uint16_t> stones; // cell index, OPPONENT_BIT set for opponent stones
+
+    static constexpr uint16_t OPPONENT_BIT = 0x8000;
+};
+
+// Streamable record file:
+//   char[4] "GTRD", u32 version, u32 board_size
+//   then per record: u64 key, i32 score, i16 best_move, i8 result, u8 depth,
+//   u16 stone_count, u16 stones[stone_count]   (all little endian)
+class TrainingWriter {
+public:
+    ~TrainingWriter();
+    bool open(const std::string& path, int board_size);
+    void write(const TrainingRecord& r);
+    bool close();
+
+private:
+    std::FILE* file = nullptr;
+};
+
+class TrainingReader {
+public:
+    ~TrainingReader();
+    bool open(const std::string& path);
+    bool next(TrainingRecord& r);
+    int board_size() const { return size; }
+
+private:
+    std::FILE* file = nullptr;
+    int size = 0;
+};
+
+// Position key recomputed from the stones; `hasher` must be init()ed to the board size
+uint64_t record_key(const TrainingRecord& r, const GomokuAI& hasher);
+
+// Applies one of the 8 symmetries of the square board (0 is the identity)
+int transform_cell(int idx, int size, int sym);
+TrainingRecord transform_record(const TrainingRecord& r, int size, int sym, const GomokuAI& hasher);
+
+// Places the record's stones on an empty board with make_move; take_back_record undoes it
+void play_record(GomokuAI& ai, const TrainingRecord& r);
+void take_back_record(GomokuAI& ai, const TrainingRecord& r);
@@ -1,7 +1,25 @@
 #include "Protocol.hpp"
+#include "ProvenResults.hpp"
+#include <cstdlib>
 
 int main() {
+    // Tuned evaluation weights (gomoku-tune output); built-in defaults otherwise
+    const char* params_path = std::getenv("PBRAIN_PARAMS");
+    load_eval_params(params_path ? params_path : "gomoku.params");
+
+    // Optional neural evaluation; the hand-tuned evaluator is used without it
+    const char* nnue_path = std::getenv("PBRAIN_NNUE");
+    load_nnue(nnue_path ? nnue_path : "gomoku.nnue");
+
+    // Positions proven in earlier games; saved back at END (INFO folder moves it)
+    const char* proven_path = std::getenv("PBRAIN_PROVEN");
+    load_proven(proven_path ? proven_path : "gomoku.proven");
+
     Protocol protocol;
+    // Opt-in session recording, for gomoku-replay
+    if (const char* session_path = std::getenv("PBRAIN_SESSION")) protocol.record_session(session_path);
+    // Opt-in game file; INFO folder moves it to <folder>/gomoku.games
+    if (const char* games_path = std::getenv("PBRAIN_GAMES")) protocol.record_games(games_path);
     protocol.run();
     return 0;
 }
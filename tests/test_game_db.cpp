@@ -0,0 +1,87 @@
+#include "../src/GameDB.hpp"
+#include "../src/GomokuAI.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+static GameRecord sample_game(uint64_t timestamp, std::vector<uint16_t> moves) {
+    GameRecord g;
+    g.board_size = 15;
+    g.result = 1;
+    g.timestamp = timestamp;
+    g.first = "pbrain-gomoku-ai";
+    g.second = "opponent";
+    g.moves = std::move(moves);
+    return g;
+}
+
+static void test_round_trip_and_lookup(const std::string& path) {
+    GameWriter out;
+    assert(out.open(path));
+    assert(out.append(sample_game(1, {112, 113, 127, 128, 142})));
+    assert(out.append(sample_game(2, {112, 113, 97})));
+    assert(out.close());
+
+    GameDB db;
+    assert(db.open(path) && db.size() == 2 && "Both games should be indexed");
+    GameRecord g = db.game(0);
+    assert(g.board_size == 15 && g.result == 1 && g.timestamp == 1 && g.first == "pbrain-gomoku-ai" &&
+           g.second == "opponent" && g.moves.size() == 5 && g.moves[4] == 142 && "Fields should survive a round trip");
+
+    // The position after 112, 113 was reached by both games at ply 2
+    GomokuAI ai;
+    ai.init(15);
+    ai.update_board(112 % 15, 112 / 15, 1);
+    ai.update_board(113 % 15, 113 / 15, 2);
+    auto found = db.find(GameDB::position_key(ai));
+    assert(found.size() == 2 && found[0].game == 0 && found[1].game == 1 && found[0].ply == 2 &&
+           "Shared position should be found in both games");
+
+    // Same stones with the colors swapped are a different position
+    ai.init(15);
+    ai.update_board(112 % 15, 112 / 15, 2);
+    ai.update_board(113 % 15, 113 / 15, 1);
+    assert(db.find(GameDB::position_key(ai)).empty());
+}
+
+static void test_append_extends_index(const std::string& path) {
+    {
+        GameWriter out;
+        assert(out.open(path));
+        assert(out.append(sample_game(3, {0, 1, 2})));
+    }
+    // A torn record at the end is ignored by readers and dropped by the next writer
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    std::fwrite("\x40\x00\x00\x00\x0f\x00", 1, 6, f);
+    std::fclose(f);
+
+    GameDB db;
+    assert(db.open(path) && db.size() == 3 && "Appended game should be indexed");
+    GomokuAI ai;
+    ai.init(15);
+    ai.update_board(0, 0, 1);
+    auto found = db.find(GameDB::position_key(ai));
+    assert(found.size() == 1 && found[0].game == 2 && found[0].ply == 1);
+    db.close();
+
+    GameWriter out;
+    assert(out.open(path));
+    assert(out.append(sample_game(4, {5})));
+    assert(out.close());
+    assert(db.open(path) && db.size() == 4 && db.game(3).timestamp == 4 && "Torn record should be replaced");
+}
+
+int main() {
+    std::string path = "/tmp/test_game_db_" + std::to_string(getpid()) + ".games";
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+    test_round_trip_and_lookup(path);
+    test_append_extends_index(path);
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    std::cout << "All game database tests passed\n";
+    return 0;
+}
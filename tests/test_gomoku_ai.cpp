@@ -1,12 +1,245 @@
 #include "../src/GomokuAI.hpp"
+#include "../src/Perft.hpp"
+#include "../src/ProvenResults.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+static constexpr int SCORE_WIN_FOR_TEST = 100000000 - 3; // a win in 3 plies
 
 // Simple helpers to set up boards quickly.
 static void place(GomokuAI& ai, std::initializer_list<std::pair<int,int>> coords, int player) {
     for (auto [x,y] : coords) ai.update_board(x, y, player);
 }
 
+static void test_make_unmake_restores_state() {
+    GomokuAI ai;
+    ai.init(15);
+    place(ai, {{7,7},{8,7}}, 1);
+    place(ai, {{7,8}}, 2);
+    uint64_t key = ai.get_hash_key();
+    std::vector<int> board = ai.board;
+    std::vector<uint8_t> neighbors = ai.neighbors;
+    std::vector<uint8_t> runs = ai.runs;
+
+    ai.make_move(0 * 15 + 0, 1);
+    ai.make_move(14 * 15 + 14, 2);
+    assert(ai.min_x == 0 && ai.max_y == 14 && "make_move should widen the bounds");
+    ai.unmake_move();
+    ai.unmake_move();
+
+    assert(ai.get_hash_key() == key && "unmake_move should restore the hash");
+    assert(ai.board == board && ai.neighbors == neighbors && ai.runs == runs && "unmake_move should restore the board");
+    assert(ai.min_x == 7 && ai.max_x == 8 && ai.min_y == 7 && ai.max_y == 8 &&
+           "unmake_move should shrink the bounds back");
+
+    // Moves next to the stones reshuffle the candidate and threat sets;
+    // unmake_move puts every list back in its exact order
+    place(ai, {{9,7}}, 1);
+    auto lists = [](const GomokuAI& g) {
+        std::vector<std::vector<int>> l = {{g.stones().begin(), g.stones().end()},
+                                           {g.candidates().begin(), g.candidates().end()}};
+        for (int p = 1; p <= 2; ++p) {
+            l.push_back({g.win_squares(p).begin(), g.win_squares(p).end()});
+            l.push_back({g.four_squares(p).begin(), g.four_squares(p).end()});
+        }
+        return l;
+    };
+    auto before = lists(ai);
+    assert(!before[2].empty() || !before[3].empty());
+    for (int idx : {6 * 15 + 7, 7 * 15 + 10, 7 * 15 + 6, 8 * 15 + 8}) ai.make_move(idx, 1 + idx % 2);
+    for (int i = 0; i < 4; ++i) ai.unmake_move();
+    assert(lists(ai) == before && "unmake_move should restore the sets in order");
+}
+
+// Runs of the shape cache recounted from the board
+static bool runs_match_board(const GomokuAI& ai) {
+    const int dx[] = {1, 0, 1, -1};
+    const int dy[] = {0, 1, 1, 1};
+    for (int idx = 0; idx < ai.width * ai.height; ++idx) {
+        for (int k = 0; k < 4; ++k) {
+            for (int p = 1; p <= 2; ++p) {
+                int count = 0;
+                for (int dir : {1, -1}) {
+                    for (int i = 1; i < 5; ++i) {
+                        int x = idx % ai.width + dir * i * dx[k], y = idx / ai.width + dir * i * dy[k];
+                        if (x < 0 || x >= ai.width || y < 0 || y >= ai.height || ai.board[y * ai.width + x] != p) break;
+                        ++count;
+                    }
+                }
+                if (ai.run_length(idx, k, p) != count) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// stones() and candidates() must list exactly the occupied cells and the
+// empty cells within distance 2 of one
+static bool cell_sets_match_board(const GomokuAI& ai) {
+    size_t stones = 0, candidates = 0;
+    for (int idx = 0; idx < ai.width * ai.height; ++idx) {
+        bool near = false;
+        for (int dy = -2; dy <= 2; ++dy) {
+            for (int dx = -2; dx <= 2; ++dx) {
+                int x = idx % ai.width + dx, y = idx / ai.width + dy;
+                near = near || (x >= 0 && x < ai.width && y >= 0 && y < ai.height && ai.board[y * ai.width + x] != 0);
+            }
+        }
+        bool candidate = ai.board[idx] == 0 && near;
+        stones += ai.board[idx] != 0;
+        candidates += candidate;
+        if (ai.stones().contains(idx) != (ai.board[idx] != 0) || ai.candidates().contains(idx) != candidate) return false;
+    }
+    return ai.stones().size() == stones && ai.candidates().size() == candidates;
+}
+
+static void test_shape_cache_tracks_board() {
+    GomokuAI ai;
+    ai.init(15);
+    unsigned seed = 7;
+    for (int i = 0; i < 120; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int idx = static_cast<int>((seed >> 8) % 225);
+        if (ai.board[idx] == 0) ai.make_move(idx, 1 + i % 2);
+        if (i % 7 == 6) ai.unmake_move();
+        if (i % 20 == 19) {
+            assert(runs_match_board(ai) && "Shape cache should follow make/unmake");
+            assert(cell_sets_match_board(ai) && "Stone and candidate sets should follow make/unmake");
+        }
+    }
+    ai.update_board(3, 3, 0);
+    ai.update_board(4, 4, 2);
+    assert(runs_match_board(ai) && "Shape cache should follow update_board");
+    assert(cell_sets_match_board(ai) && "Stone and candidate sets should follow update_board");
+}
+
+// Win squares must be exactly the cells completing five; four squares the
+// empty cells of a 5-cell window holding three stones of one player only
+static bool threats_match_board(GomokuAI& ai) {
+    const int dx[] = {1, 0, 1, -1};
+    const int dy[] = {0, 1, 1, 1};
+    int cells = ai.width * ai.height;
+    for (int p = 1; p <= 2; ++p) {
+        std::vector<bool> four(cells, false);
+        for (int s = 0; s < cells; ++s) {
+            for (int k = 0; k < 4; ++k) {
+                int ex = s % ai.width + 4 * dx[k], ey = s / ai.width + 4 * dy[k];
+                if (ex < 0 || ex >= ai.width || ey >= ai.height) continue;
+                int own = 0, other = 0;
+                for (int i = 0; i < 5; ++i) {
+                    int c = s + i * (dy[k] * ai.width + dx[k]);
+                    own += ai.board[c] == p;
+                    other += ai.board[c] == 3 - p;
+                }
+                if (own != 3 || other != 0) continue;
+                for (int i = 0; i < 5; ++i) {
+                    int c = s + i * (dy[k] * ai.width + dx[k]);
+                    if (ai.board[c] == 0) four[c] = true;
+                }
+            }
+        }
+        size_t wins = 0, fours = 0;
+        for (int c = 0; c < cells; ++c) {
+            if (ai.board[c] != 0) continue;
+            ai.make_move(c, p);
+            bool win = ai.is_five(c);
+            ai.unmake_move();
+            wins += win;
+            fours += four[c];
+            if (ai.win_squares(p).contains(c) != win || ai.four_squares(p).contains(c) != four[c]) return false;
+        }
+        if (ai.win_squares(p).size() != wins || ai.four_squares(p).size() != fours) return false;
+    }
+    return true;
+}
+
+static void test_threat_registry_tracks_board() {
+    GomokuAI ai;
+    ai.init(12);
+    unsigned seed = 11;
+    for (int i = 0; i < 150; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int idx = static_cast<int>((seed >> 8) % 144);
+        if (ai.board[idx] == 0) ai.make_move(idx, 1 + i % 2);
+        if (i % 5 == 4) ai.unmake_move();
+        if (i % 10 == 9) {
+            assert(threats_match_board(ai) && "Threat registry should follow make/unmake");
+        }
+    }
+    place(ai, {{0,0},{1,1},{2,2},{3,3}}, 2);
+    ai.update_board(5, 5, 0);
+    assert(threats_match_board(ai) && "Threat registry should follow update_board");
+    ai.init(12);
+    assert(ai.win_squares(1).empty() && ai.four_squares(2).empty() && "init should clear the registry");
+}
+
+static void test_large_board_search() {
+    // History is indexed by cell, so cells past 20x20 must not overflow it
+    GomokuAI ai;
+    ai.init(60);
+    place(ai, {{50,50},{51,51},{52,52},{53,53}}, 2);
+    place(ai, {{40,40},{41,40},{42,41}}, 1);
+    SearchLimits limits;
+    limits.max_depth = 4;
+    Point p = ai.find_best_move(limits);
+    assert(((p.x == 49 && p.y == 49) || (p.x == 54 && p.y == 54)) && "Four should be blocked on a 60x60 board");
+
+    ai.update_board(p.x, p.y, 1);
+    ai.update_board(45, 20, 2);
+    Point q = ai.find_best_move(limits);
+    assert(q.x >= 0 && q.x < 60 && q.y >= 0 && q.y < 60 && ai.board[q.y * 60 + q.x] == 0 &&
+           "Search should return an empty cell on a large board");
+}
+
+static void test_perft_counts() {
+    GomokuAI ai;
+    ai.init(15);
+    ai.update_board(7, 7, 2);
+    assert(perft(ai, 0).leaves == 1 && perft(ai, 1).leaves == 24 && "One stone has 24 candidates around it");
+
+    // Depth 2: the candidates left after each first move, counted by brute force
+    uint64_t expected = 0;
+    for (int idx = 0; idx < 225; ++idx) {
+        if (!ai.candidates().contains(idx)) continue;
+        ai.make_move(idx, 1);
+        for (int c = 0; c < 225; ++c) {
+            bool near = false;
+            for (int s : ai.stones()) near = near || (std::abs(s % 15 - c % 15) <= 2 && std::abs(s / 15 - c / 15) <= 2);
+            expected += ai.board[c] == 0 && near;
+        }
+        ai.unmake_move();
+    }
+    PerftResult two = perft(ai, 2);
+    assert(two.leaves == expected && two.nodes == 1 + 24 + expected && "Depth 2 should count every reply");
+
+    PerftResult three = perft(ai, 3);
+    PerftResult split = perft(ai, 3, 1, 3);
+    assert(three.leaves == split.leaves && three.nodes == split.nodes && "Root split should not change the counts");
+}
+
+static void test_eval_params_drive_evaluation() {
+    GomokuAI ai;
+    ai.init(15);
+    place(ai, {{6,7},{7,7}}, 1); // open two
+    int base = ai.static_eval(1);
+    assert(base == ai.params.live_2 * ai.params.attack_bias / 100 && "Open two should score live_2 with the attack bias");
+
+    ai.params.live_2 = 400;
+    assert(ai.static_eval(1) == 440 && "Evaluation should use the runtime weights");
+
+    std::string path = "/tmp/test_eval_params.params";
+    assert(ai.params.save(path));
+    EvalParams loaded;
+    assert(loaded.load(path) && loaded.live_2 == 400 && loaded.live_4 == ai.params.live_4 &&
+           "Parameters should survive a save/load round trip");
+    std::remove(path.c_str());
+}
+
 static void test_center_start() {
     GomokuAI ai;
     ai.init(10);
@@ -83,6 +316,209 @@ static void test_block_open_three_over_filler() {
     assert((blocks_top || blocks_bottom) && "Should block opponent open three instead of a neutral move");
 }
 
+static void test_parallel_root_blocks_open_three() {
+    GomokuAI ai;
+    ai.init(15);
+    ai.set_threads(3);
+    place(ai, {{6,7},{7,7},{8,7}}, 2);
+    place(ai, {{7,8}}, 1);
+
+    Point p = ai.find_best_move(1000);
+    bool block = (p.x == 5 && p.y == 7) || (p.x == 9 && p.y == 7);
+    assert(block && "Parallel root search should still block an open three");
+}
+
+static void test_helper_threads_are_reused() {
+    GomokuAI ai;
+    std::vector<std::thread::id> ids[2];
+    for (auto& round : ids) {
+        round.assign(3, std::thread::id());
+        ai.run_parallel(3, [&](int self) { round[self] = std::this_thread::get_id(); });
+    }
+    assert(ids[0][0] == std::this_thread::get_id() && "Job 0 should run on the calling thread");
+    assert(ids[0][1] != ids[0][0] && ids[0][2] != ids[0][0] && ids[0][1] != ids[0][2] && "Helpers are separate threads");
+    assert(ids[0] == ids[1] && "A later round should run on the same helpers");
+
+    // Fewer jobs leave the extra helper idle; a copy gets helpers of its own
+    int ran = 0;
+    ai.run_parallel(2, [&](int self) { ran += self == 2; });
+    GomokuAI copy = ai;
+    std::thread::id copy_helper;
+    copy.run_parallel(2, [&](int self) { if (self == 1) copy_helper = std::this_thread::get_id(); });
+    assert(ran == 0 && copy_helper != ids[0][1] && copy_helper != std::thread::id());
+}
+
+static void test_node_limit_is_reproducible() {
+    SearchLimits limits;
+    limits.max_nodes = 20000;
+    GomokuAI ai;
+    auto run = [&](int threads) {
+        ai.init(15);
+        ai.set_threads(threads);
+        place(ai, {{7,7},{8,8},{6,8}}, 1);
+        place(ai, {{7,8},{8,7},{9,9}}, 2);
+        Point p = ai.find_best_move(limits);
+        return std::make_tuple(p.y * 15 + p.x, ai.last_search().score, ai.last_search().depth, ai.last_search().nodes);
+    };
+    auto first = run(1);
+    assert(std::get<3>(first) <= limits.max_nodes && "Search should stop at the node limit");
+
+    // Leave TT, eval cache and history entries from other searches behind,
+    // on this board and on a copy of it searching from another thread
+    place(ai, {{5,5}}, 1);
+    ai.find_best_move(300);
+    GomokuAI other;
+    other.init(15);
+    place(other, {{3,3},{4,4}}, 1);
+    place(other, {{3,4}}, 2);
+    std::thread([&] { other.find_best_move(limits); }).join();
+    assert(first == run(1) && "init() and the same moves should reproduce the search after other searches");
+
+    // Parallel searches are not reproducible, but all threads draw on one
+    // node budget: each may only be a flush stride (4096 nodes) behind
+    auto parallel = run(3);
+    assert(std::get<3>(parallel) > 0 && std::get<3>(parallel) <= limits.max_nodes + 3 * 4096 &&
+           "Helper threads should count against the same node budget");
+
+    limits.max_nodes = 0;
+    limits.max_depth = 2;
+    ai.init(15);
+    place(ai, {{7,7}}, 1);
+    place(ai, {{7,8}}, 2);
+    ai.find_best_move(limits);
+    assert(ai.last_search().depth == 2 && "Depth-limited search should stop at max_depth");
+}
+
+static void test_multipv_ranks_distinct_moves() {
+    SearchLimits limits;
+    limits.max_depth = 3;
+    auto setup = [](GomokuAI& ai) {
+        ai.init(15);
+        place(ai, {{7,7},{8,8}}, 1);
+        place(ai, {{7,8},{8,7}}, 2);
+    };
+    GomokuAI single;
+    setup(single);
+    Point best = single.find_best_move(limits);
+
+    GomokuAI ai;
+    setup(ai);
+    ai.set_multipv(4);
+    Point p = ai.find_best_move(limits);
+    const auto& lines = ai.last_lines();
+    assert(lines.size() == 4 && "Multi-PV should return the requested number of lines");
+    assert(p.x == best.x && p.y == best.y && lines[0].score == single.last_search().score &&
+           "The first line should match a single-PV search");
+    for (size_t i = 0; i < lines.size(); ++i) {
+        assert(!lines[i].pv.empty() && lines[i].pv[0].x == lines[i].move.x && lines[i].pv[0].y == lines[i].move.y);
+        assert(lines[i].pv.size() <= 3 && "PV should not be longer than the depth");
+        for (size_t j = 0; j < i; ++j) {
+            assert(lines[j].score >= lines[i].score && "Lines should be sorted by score");
+            assert((lines[j].move.x != lines[i].move.x || lines[j].move.y != lines[i].move.y) &&
+                   "Lines should rank distinct root moves");
+        }
+    }
+}
+
+static void test_proven_results_survive_init() {
+    GomokuAI ai;
+    ai.init(11);
+    place(ai, {{5,5},{5,6}}, 1);
+    place(ai, {{6,5},{6,6}}, 2);
+    uint64_t key = ProvenResults::key_for(ai.get_hash_key(), 11);
+    proven_results().store(key, SCORE_WIN_FOR_TEST, 0);
+
+    std::string path = "/tmp/test_proven_" + std::to_string(std::rand()) + ".bin";
+    assert(load_proven(path) == false && save_proven() && "Saving should create the store");
+    assert(load_proven(path) && !proven_results().dirty() && "The store should map back from disk");
+
+    ai.init(11); // init() must not forget proven positions
+    place(ai, {{5,5},{5,6}}, 1);
+    place(ai, {{6,5},{6,6}}, 2);
+    Point p = ai.find_best_move(1000);
+    assert(p.x == 0 && p.y == 0 && ai.last_search().score == SCORE_WIN_FOR_TEST &&
+           "A proven position should be answered from the store");
+
+    SearchLimits limits;
+    limits.max_depth = 1;
+    p = ai.find_best_move(limits);
+    assert(!(p.x == 0 && p.y == 0) && "Reproducible searches should not use the store");
+    std::remove(path.c_str());
+}
+
+static void test_saturated_eval_is_not_proven() {
+    GomokuAI ai;
+    ai.init(15);
+    // A weight at the tuner's bound: two open twos alone score past a won score
+    ai.params.live_2 = 100000000;
+    ai.params.attack_bias = 100;
+    place(ai, {{3,7},{4,7},{9,3},{9,4}}, 1);
+    place(ai, {{12,12}}, 2);
+    const int won_band = 100000000 - 1000; // scores treated as proven wins
+    assert(ai.static_eval(1) < won_band && "A heuristic score should stay below the won band");
+
+    // Timed, so the proven store is in use; two plies cannot reach a five
+    SearchLimits limits;
+    limits.max_time = 2000;
+    limits.max_depth = 2;
+    ai.find_best_move(limits);
+    ProvenEntry entry;
+    assert(ai.last_search().score < won_band &&
+           !proven_results().probe(ProvenResults::key_for(ai.get_hash_key(), 15), entry) &&
+           "A saturated evaluation should not be stored as proven");
+}
+
+static void test_sync_board_matches_fresh_init() {
+    GomokuAI ai;
+    ai.init(15);
+    place(ai, {{7,7},{8,8},{9,9}}, 1);
+    place(ai, {{7,8},{6,6}}, 2);
+
+    std::vector<int> target(15 * 15, 0);
+    target[7 * 15 + 7] = 1;
+    target[9 * 15 + 9] = 2;  // recolored
+    target[3 * 15 + 12] = 1; // added
+    assert(ai.sync_board(target) == 5 && "Two removals, one recolor and one addition");
+
+    GomokuAI fresh;
+    fresh.init(15);
+    place(fresh, {{7,7},{12,3}}, 1);
+    place(fresh, {{9,9}}, 2);
+    assert(ai.board == fresh.board && ai.neighbors == fresh.neighbors && ai.get_hash_key() == fresh.get_hash_key() &&
+           "Incremental state should match a board built from scratch");
+    assert(ai.min_x == 7 && ai.max_x == 12 && ai.min_y == 3 && ai.max_y == 9 && "Bounds should shrink after removals");
+    assert(ai.sync_board(target) == 0 && ai.sync_board(std::vector<int>(4, 0)) == -1);
+
+    // Move ordering learned before a re-sync is kept for the next search
+    SearchLimits limits;
+    limits.max_depth = 4;
+    ai.find_best_move(limits);
+    std::vector<int> history = ai.history_moves;
+    assert(std::any_of(history.begin(), history.end(), [](int h) { return h > 0; }) && "The search should fill history");
+    target[10 * 15 + 10] = 2;
+    assert(ai.sync_board(target) == 1 && ai.history_moves == history && "sync_board should keep the history");
+}
+
+static void test_memory_limit_bounds_tables() {
+    GomokuAI ai;
+    ai.set_threads(2);
+    ai.set_memory_limit(64 << 20);
+    ai.init(15);
+    MemoryUsage m = ai.memory_usage();
+    assert(m.total() <= (64 << 20) && m.tt >= (32 << 20) && "Tables should fill most of the budget");
+    assert((m.tt & (m.tt - 1)) == 0 && m.history > 0 && m.search > 0);
+
+    ai.set_memory_limit(1 << 20); // below what the engine needs: smallest tables
+    assert(ai.memory_usage().tt < (1 << 20) && "Tight budgets should shrink the TT");
+    place(ai, {{6,7},{7,7},{8,7}}, 2);
+    place(ai, {{7,8}}, 1);
+    Point p = ai.find_best_move(500);
+    assert(((p.x == 5 || p.x == 9) && p.y == 7) && "Search should still work with small tables");
+
+    ai.set_memory_limit(0);
+    assert(ai.memory_usage().tt == (16 << 20) && "No limit should restore the default TT");
+}
+
 static void test_block_open_or_hidden_four() {
     GomokuAI ai;
     ai.init(10);
@@ -151,6 +587,92 @@ static void test_prefer_open_four_over_defense() {
 }
 */
 
+static void test_open_three_restricts_replies() {
+    GomokuAI ai;
+    ai.init(15);
+    // Open three with room on both sides: only the adjacent ends stop an open four
+    place(ai, {{5,7},{6,7},{7,7}}, 2);
+    place(ai, {{6,5},{10,10}}, 1);
+    SearchLimits limits;
+    limits.max_depth = 4;
+    Point p = ai.find_best_move(limits);
+    assert(p.y == 7 && (p.x == 4 || p.x == 8) && "Open three should be blocked at an adjacent end");
+    assert(ai.last_search().score > -SCORE_WIN_FOR_TEST / 2 && "Blocked open three should not be scored as lost");
+}
+
+static void test_extensions_can_be_toggled() {
+    SearchLimits limits;
+    limits.max_depth = 3;
+    auto run = [&](unsigned mask) {
+        GomokuAI ai;
+        ai.init(15);
+        ai.set_extensions(mask);
+        place(ai, {{5,7},{6,7},{7,7}}, 2);
+        place(ai, {{6,5},{10,10}}, 1);
+        Point p = ai.find_best_move(limits);
+        assert(p.y == 7 && (p.x == 4 || p.x == 8) && "Open three should be blocked with any extensions");
+        return ai.last_search().nodes;
+    };
+    assert(run(EXT_ALL) > run(0) && "Extensions should search forcing lines deeper");
+    GomokuAI ai;
+    ai.set_extensions(~0u);
+    assert(ai.get_extensions() == EXT_ALL && "Unknown extension bits should be dropped");
+}
+
+static void test_mcts_backend() {
+    SearchLimits limits;
+    limits.max_nodes = 30000;
+    auto run = [&](int threads) {
+        GomokuAI ai;
+        ai.init(15);
+        ai.set_backend(SearchBackend::MCTS);
+        ai.set_threads(threads);
+        ai.set_multipv(2);
+        place(ai, {{5,7},{6,7},{7,7}}, 2);
+        place(ai, {{6,5},{10,10}}, 1);
+        Point p = ai.find_best_move(limits);
+        assert(p.y == 7 && (p.x == 4 || p.x == 8) && "MCTS should block the open three");
+        assert(ai.last_lines().size() == 2 && ai.last_lines()[0].pv.size() > 1 && "MCTS should report ranked lines");
+        return std::make_tuple(p.x, ai.last_search().score, ai.last_search().nodes);
+    };
+    auto first = run(1);
+    // A timed search in between leaves TT entries and a used tree arena behind
+    GomokuAI other;
+    other.init(15);
+    place(other, {{3,3},{4,4}}, 1);
+    other.find_best_move(300);
+    assert(first == run(1) && "Node-limited MCTS on one thread should be reproducible");
+    run(3);
+
+    GomokuAI ai;
+    ai.init(10);
+    ai.set_backend(SearchBackend::MCTS);
+    place(ai, {{0,5},{1,5},{2,5},{3,5}}, 1);
+    Point p = ai.find_best_move(2000);
+    assert(p.x == 4 && p.y == 5 && "MCTS should keep the tactical pre-pass");
+}
+
+static void test_best_move_so_far_follows_search() {
+    GomokuAI ai;
+    ai.init(15);
+    place(ai, {{5,7},{6,7},{7,7}}, 2);
+    place(ai, {{6,5},{10,10}}, 1);
+    ai.clear_stop();
+    assert(ai.best_move_so_far().x == -1 && "No search yet, no best move");
+    SearchLimits limits;
+    limits.max_depth = 3;
+    Point p = ai.find_best_move(limits);
+    Point so_far = ai.best_move_so_far();
+    assert(so_far.x == p.x && so_far.y == p.y && "Best move so far should end as the search's move");
+
+    // A stopped search still publishes its ordered first move
+    ai.stop_search();
+    ai.find_best_move(limits);
+    assert(ai.best_move_so_far().x >= 0 && "A stopped search should still have a move to offer");
+    ai.clear_stop();
+    assert(ai.best_move_so_far().x == -1 && "clear_stop should forget the last search's move");
+}
+
 // 1. Strict Adjacent Block for Open Four threat (formerly ..000..)
 static void test_strict_adjacent_block_open_three() {
     GomokuAI ai;
@@ -329,12 +851,26 @@ static void test_tactical_puzzles() {
 }
 
 int main() {
+    test_make_unmake_restores_state();
+    test_shape_cache_tracks_board();
+    test_threat_registry_tracks_board();
+    test_large_board_search();
+    test_perft_counts();
+    test_eval_params_drive_evaluation();
     test_center_start();
     test_immediate_win();
     test_block_opponent_win();
     // test_avoid_weak_closed_four();
     // test_avoid_neutral_filler();
     test_block_open_three_over_filler();
+    test_parallel_root_blocks_open_three();
+    test_helper_threads_are_reused();
+    test_node_limit_is_reproducible();
+    test_multipv_ranks_distinct_moves();
+    test_proven_results_survive_init();
+    test_saturated_eval_is_not_proven();
+    test_memory_limit_bounds_tables();
+    test_sync_board_matches_fresh_init();
     test_block_open_or_hidden_four();
     test_defensive_forced_win_block();
     // test_prefer_double_threat_attack();
@@ -346,6 +882,10 @@ int main() {
     test_block_diagonal_broken_three();
     // test_create_open_four_priority(); // Prepass blocks 4-threats before search weighs attack priority
     test_block_open_four_priority();
+    test_open_three_restricts_replies();
+    test_extensions_can_be_toggled();
+    test_mcts_backend();
+    test_best_move_so_far_follows_search();
     test_block_broken_four_prepass();
     test_block_open_four_prepass_edge();
     test_block_diagonal_four_threat_prepass();
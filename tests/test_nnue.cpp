@@ -0,0 +1,83 @@
+#include "../src/GomokuAI.hpp"
+#include "../src/NNUE.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// Deterministic small random network for a 9x9 board
+static NNUENetwork make_network() {
+    NNUENetwork net;
+    net.board_size = 9;
+    net.hidden = 64;
+    net.output_bias = 250;
+    net.output_divisor = 16;
+    uint32_t seed = 12345;
+    auto rnd = [&](int lo, int hi) {
+        seed = seed * 1103515245u + 12345u;
+        return lo + static_cast<int>((seed >> 8) % static_cast<uint32_t>(hi - lo + 1));
+    };
+    for (int i = 0; i < net.hidden; ++i) net.ft_bias.push_back(static_cast<int16_t>(rnd(-20, 60)));
+    for (int i = 0; i < 9 * 9 * 2 * net.hidden; ++i) net.ft_weights.push_back(static_cast<int16_t>(rnd(-40, 40)));
+    for (int i = 0; i < 2 * net.hidden; ++i) net.out_weights.push_back(static_cast<int8_t>(rnd(-128, 127)));
+    return net;
+}
+
+// Straightforward scalar forward pass from the board alone
+static int reference_eval(const NNUENetwork& net, const std::vector<int>& board, int player) {
+    std::vector<int16_t> acc(2 * net.hidden);
+    net.refresh(board, acc.data());
+    int sum = net.output_bias;
+    for (int i = 0; i < net.hidden; ++i) {
+        sum += std::clamp<int>(acc[(player - 1) * net.hidden + i], 0, 127) * net.out_weights[i];
+        sum += std::clamp<int>(acc[(2 - player) * net.hidden + i], 0, 127) * net.out_weights[net.hidden + i];
+    }
+    return sum / net.output_divisor;
+}
+
+static void test_load_round_trip(const std::string& path) {
+    NNUENetwork net = make_network();
+    assert(net.save(path) && "Network should be written");
+    NNUENetwork loaded;
+    assert(loaded.load(path) && "Network should load back");
+    assert(loaded.ft_weights == net.ft_weights && loaded.out_weights == net.out_weights &&
+           "Weights should survive a save/load round trip");
+    assert(load_nnue(path) && "Global network should load");
+}
+
+static void test_incremental_accumulator() {
+    GomokuAI ai;
+    ai.init(9);
+    assert(ai.nnue != nullptr && "A 9x9 board should pick up the 9x9 network");
+
+    ai.update_board(4, 4, 1);
+    ai.update_board(5, 4, 2);
+    ai.update_board(5, 4, 1); // overwrite
+    ai.make_move(3 * 9 + 3, 2);
+    ai.make_move(6 * 9 + 2, 1);
+    ai.unmake_move();
+    ai.make_move(0, 1);
+
+    std::vector<int16_t> fresh(ai.accumulator.size());
+    ai.nnue->refresh(ai.board, fresh.data());
+    assert(fresh == ai.accumulator && "Incremental accumulator should match a full refresh");
+
+    for (int player = 1; player <= 2; ++player) {
+        assert(ai.nnue->evaluate(ai.accumulator.data(), player) == reference_eval(*ai.nnue, ai.board, player) &&
+               "Vectorized output layer should match the scalar reference");
+    }
+
+    ai.init(10);
+    assert(ai.nnue == nullptr && "Other board sizes should fall back to the classical evaluator");
+}
+
+int main() {
+    std::string path = "/tmp/test_nnue_" + std::to_string(std::rand()) + ".nnue";
+    test_load_round_trip(path);
+    test_incremental_accumulator();
+    std::remove(path.c_str());
+
+    std::cout << "All NNUE tests passed\n";
+    return 0;
+}
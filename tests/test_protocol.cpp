@@ -1,37 +1,131 @@
 #include "../src/Protocol.hpp"
+#include "../src/GameDB.hpp"
 #include "../src/GomokuAI.hpp"
+#include "../src/Session.hpp"
 #include <cassert>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Pipes the protocol reads its commands from and writes its replies into
+struct ProtocolPipes {
+    int in[2];
+    int out[2];
+    ProtocolPipes() {
+        int rc = pipe(in) | pipe(out);
+        assert(rc == 0);
+        (void)rc;
+        fcntl(out[0], F_SETFL, O_NONBLOCK);
+    }
+    ~ProtocolPipes() {
+        close(in[0]);
+        if (in[1] >= 0) close(in[1]);
+        close(out[0]);
+        close(out[1]);
+    }
+};
+
+// Fresh directory for files the protocol writes, removed with its contents
+struct TempDir {
+    std::string path;
+    TempDir() {
+        char name[] = "/tmp/test_protocol_XXXXXX";
+        char* made = mkdtemp(name);
+        assert(made && "mkdtemp should succeed");
+        path = made ? made : "";
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+};
 
 // Mock Protocol class for testing
-class TestableProtocol : public Protocol {
+class TestableProtocol : private ProtocolPipes, public Protocol {
 public:
+    TestableProtocol() : ProtocolPipes(), Protocol(in[0], out[1]) {}
+
     // Make private methods accessible for testing
     using Protocol::handle_start;
     using Protocol::handle_turn;
     using Protocol::handle_begin;
     using Protocol::handle_about;
+    using Protocol::finish_search;
+    using Protocol::turn_time_limit;
+    using Protocol::search_limits;
 
     // Access to the AI for verification
     GomokuAI& get_ai() { return ai; }
+
+    // Input for a run() on another thread
+    void send(const std::string& text) {
+        ssize_t n = write(in[1], text.data(), text.size());
+        assert(n == static_cast<ssize_t>(text.size()));
+        (void)n;
+    }
+    // The protocol reads EOF once the input sent so far is consumed
+    void close_input() {
+        close(in[1]);
+        in[1] = -1;
+    }
+    // Runs the protocol over `input` until END or the end of the input, and
+    // returns everything it wrote
+    std::string run_script(const std::string& input) {
+        send(input);
+        close_input();
+        run();
+        return output();
+    }
+
+    // Everything written since the last call
+    std::string output() {
+        std::string out_text;
+        char buf[4096];
+        for (ssize_t n; (n = read(out[0], buf, sizeof(buf))) > 0;) out_text.append(buf, n);
+        return out_text;
+    }
+};
+
+// Search that keeps running well past its stop, as a descheduled or stuck search would
+class OverrunningProtocol : public TestableProtocol {
+public:
+    using TestableProtocol::TestableProtocol;
+
+protected:
+    Point think(const SearchLimits& turn_limits) override {
+        Point p = ai.find_best_move(turn_limits);
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        return p;
+    }
 };
 
+// Milliseconds from now until `protocol` has written a move line, or -1 after 2 s
+static long wait_for_move(TestableProtocol& protocol, std::string& output,
+                          std::chrono::steady_clock::time_point since) {
+    while (std::chrono::steady_clock::now() - since < std::chrono::seconds(2)) {
+        output += protocol.output();
+        size_t comma = output.find(',');
+        if (comma != std::string::npos && output.find('\n', comma) != std::string::npos) {
+            return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - since).count());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return -1;
+}
+
 static void test_start_valid_size() {
     TestableProtocol protocol;
     std::string cmd = "START 15";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("OK") != std::string::npos && "Should respond with OK for valid size");
     assert(protocol.get_ai().width == 15 && "Board size should be 15");
 }
@@ -40,34 +134,30 @@ static void test_start_minimum_size() {
     TestableProtocol protocol;
     std::string cmd = "START 5";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("OK") != std::string::npos && "Size 5 should be accepted");
     assert(protocol.get_ai().width == 5 && "Board size should be 5");
 }
 
+static void test_start_selects_backend() {
+    TestableProtocol protocol;
+    protocol.handle_start("START 15 mcts");
+    assert(protocol.get_ai().get_backend() == SearchBackend::MCTS && "START should accept a backend");
+    protocol.handle_start("START 15");
+    assert(protocol.get_ai().get_backend() == SearchBackend::MCTS && "The backend should persist across games");
+    protocol.handle_start("START 15 alphabeta");
+    assert(protocol.get_ai().get_backend() == SearchBackend::AlphaBeta);
+}
+
 static void test_start_unsupported_size_4() {
     TestableProtocol protocol;
     std::string cmd = "START 4";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("ERROR unsupported size") != std::string::npos &&
            "Should respond with ERROR unsupported size for size < 5");
 }
@@ -76,16 +166,9 @@ static void test_start_unsupported_size_1() {
     TestableProtocol protocol;
     std::string cmd = "START 1";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("ERROR unsupported size") != std::string::npos &&
            "Should respond with ERROR unsupported size for size < 5");
 }
@@ -94,16 +177,9 @@ static void test_start_unsupported_size_0() {
     TestableProtocol protocol;
     std::string cmd = "START 0";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("ERROR unsupported size") != std::string::npos &&
            "Should respond with ERROR unsupported size for size < 5");
 }
@@ -112,34 +188,27 @@ static void test_start_large_size() {
     TestableProtocol protocol;
     std::string cmd = "START 19";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("OK") != std::string::npos && "Large size should be accepted");
     assert(protocol.get_ai().width == 19 && "Board size should be 19");
 }
 
+static void test_start_unsupported_size_too_large() {
+    TestableProtocol protocol;
+    protocol.handle_start("START 182");
+    assert(protocol.output().find("ERROR unsupported size") != std::string::npos &&
+           "Sizes beyond MAX_BOARD_SIZE should be refused");
+}
+
 static void test_start_default_size() {
     TestableProtocol protocol;
     std::string cmd = "START";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_start(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("OK") != std::string::npos && "Should use default size when not specified");
     assert(protocol.get_ai().width == 20 && "Default board size should be 20");
 }
@@ -148,16 +217,9 @@ static void test_about_command() {
     TestableProtocol protocol;
     std::string cmd = "ABOUT";
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     protocol.handle_about(cmd);
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     assert(output.find("pbrain-gomoku-ai") != std::string::npos &&
            "ABOUT should contain engine name");
     assert(output.find("version") != std::string::npos &&
@@ -173,16 +235,9 @@ static void test_turn_updates_opponent() {
     std::string start_cmd = "START 10";
     protocol.handle_start(start_cmd);
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     std::string turn_cmd = "TURN 5,5";
     protocol.handle_turn(turn_cmd);
 
-    std::cout.rdbuf(old);
-
     // Verify opponent move was placed and our move was made
     int width = protocol.get_ai().width;
     assert(protocol.get_ai().board[5 * width + 5] == 2 &&
@@ -196,31 +251,312 @@ static void test_begin_plays_first_move() {
     std::string start_cmd = "START 20";
     protocol.handle_start(start_cmd);
 
-    // Capture output
-    std::streambuf* old = std::cout.rdbuf();
-    std::stringstream ss;
-    std::cout.rdbuf(ss.rdbuf());
-
     std::string begin_cmd = "BEGIN";
     protocol.handle_begin(begin_cmd);
+    protocol.finish_search();
 
-    std::cout.rdbuf(old);
-
-    std::string output = ss.str();
+    std::string output = protocol.output();
     // Output should be coordinates
     assert(output.find(",") != std::string::npos &&
            "BEGIN should output coordinates");
 }
 
+static void test_run_reads_board_from_fd() {
+    TempDir dir;
+    std::string script = "START 10\r\nINFO timeout_turn 300 folder " + dir.path +
+                         "\nBOARD\n4,4,2\n5,4,1\n6,4,2\nDONE\nEND\n";
+
+    TestableProtocol protocol;
+    std::string output = protocol.run_script(script);
+
+    GomokuAI& ai = protocol.get_ai();
+    assert(ai.board[4 * 10 + 4] == 2 && ai.board[4 * 10 + 5] == 1 && ai.board[4 * 10 + 6] == 2 &&
+           "BOARD stones should be placed");
+    assert(output.rfind("OK\n", 0) == 0 && output.find(',') != std::string::npos &&
+           "START then BOARD should reply OK and a move");
+}
+
+static void test_history_survives_between_turns() {
+    std::string script = "START 15\nINFO timeout_turn 0 max_depth 4\nTURN 7,7\n";
+
+    TestableProtocol protocol;
+    protocol.run_script(script);
+
+    // Searches run on their own thread; what they learn belongs to the engine
+    std::vector<int> first = protocol.get_ai().history_moves;
+    long first_sum = 0;
+    for (int h : first) first_sum += h;
+    assert(first_sum > 0 && "The first turn's search should fill the history table");
+
+    protocol.handle_turn("TURN 8,8");
+    protocol.finish_search();
+    const std::vector<int>& second = protocol.get_ai().history_moves;
+    long second_sum = 0;
+    for (size_t i = 0; i < second.size(); ++i) {
+        assert(second[i] >= first[i] && "History should carry over to the next turn");
+        second_sum += second[i];
+    }
+    assert(second_sum > first_sum && "The second turn should add to the history");
+}
+
+static void test_board_resync_applies_only_the_diff() {
+    // The second BOARD drops 4,4, keeps 5,4 and 6,4 and adds 2,2; the bad lines are ignored
+    std::string script = "START 10\nINFO timeout_turn 200\nBOARD\n4,4,2\n5,4,1\n6,4,2\nDONE\n"
+                         "BOARD\n5,4,1\n6,4,2\n2,2,2\n2,2,1\n10,3,1\n3,3,7\nDONE\n";
+
+    TestableProtocol protocol;
+    std::string output = protocol.run_script(script);
+
+    GomokuAI& ai = protocol.get_ai();
+    assert(ai.board[4 * 10 + 4] == 0 && ai.board[4 * 10 + 5] == 1 && ai.board[4 * 10 + 6] == 2 &&
+           ai.board[2 * 10 + 2] == 2 && ai.board[3 * 10 + 3] == 0 && "BOARD should leave the manager's position");
+    int stones = 0;
+    for (int c : ai.board) stones += c != 0;
+    assert(stones == 4 && "Only the resent stones and our reply should be on the board");
+    assert(output.find("DEBUG BOARD: ignored") != std::string::npos && "Invalid stones should be reported");
+}
+
+static void test_multipv_reports_lines() {
+    std::string script = "START 15\nINFO timeout_turn 0\nINFO max_depth 2 multipv 3 extensions 5\nBOARD\n7,7,2\n8,8,1\nDONE\n";
+
+    TestableProtocol protocol;
+    std::string output = protocol.run_script(script);
+
+    size_t pv3 = output.find("MESSAGE pv 3 score ");
+    assert(output.find("MESSAGE pv 1 score ") != std::string::npos && pv3 != std::string::npos &&
+           "multipv 3 should report three lines");
+    assert(output.find("depth 2 ", pv3) != std::string::npos && "Lines should carry the searched depth");
+    assert(protocol.get_ai().get_extensions() == (EXT_FOUR | EXT_SINGLE_REPLY) && "INFO extensions should set the mask");
+}
+
+static void test_info_selects_mcts() {
+    std::string script = "START 15\nINFO timeout_turn 0\nINFO max_depth 1 search mcts\nBOARD\n7,7,2\n8,8,1\nDONE\n";
+
+    TestableProtocol protocol;
+    protocol.run_script(script);
+
+    assert(protocol.get_ai().get_backend() == SearchBackend::MCTS && "INFO search should pick the backend");
+    int stones = 0;
+    for (int c : protocol.get_ai().board) stones += c != 0;
+    assert(stones == 3 && "MCTS should play a move");
+}
+
+static void test_perft_command() {
+    // BEGIN plays the center, so PERFT 1 sees one stone with 24 cells around it
+    std::string script = "START 15\nBEGIN\nPERFT 1 2\nPERFT\n";
+
+    TestableProtocol protocol;
+    std::string output = protocol.run_script(script);
+
+    assert(output.find("MESSAGE perft depth 1 leaves 24 nodes 25 ") != std::string::npos && "PERFT should report counts");
+    assert(output.find("ERROR PERFT needs a depth") != std::string::npos && "PERFT without a depth is an error");
+}
+
+static void test_stop_interrupts_search() {
+    TestableProtocol protocol;
+    std::thread reader([&] { protocol.run(); });
+
+    // timeout_turn 0: think until told otherwise
+    std::string script = "START 15\nINFO timeout_turn 0\nBOARD\n7,7,2\n8,8,1\nDONE\n";
+    protocol.send(script);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    auto start = std::chrono::steady_clock::now();
+    protocol.send("STOP\nEND\n");
+    reader.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    assert(elapsed < std::chrono::seconds(1) && "STOP should end the search right away");
+    std::string output = protocol.output();
+    assert(output.find(',') != std::string::npos && "STOP should still reply with a move");
+}
+
+static void test_timed_turn_replies_before_deadline() {
+    TestableProtocol protocol;
+    std::thread reader([&] { protocol.run(); });
+
+    std::string setup = "START 20\nINFO timeout_turn 150\n";
+    protocol.send(setup);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    protocol.output(); // OK
+    std::string output;
+
+    std::string board = "BOARD\n9,9,2\n10,10,1\n10,9,2\n8,10,1\n11,8,2\nDONE\n";
+    auto start = std::chrono::steady_clock::now();
+    protocol.send(board);
+    long ms = wait_for_move(protocol, output, start);
+    protocol.send("END\n");
+    reader.join();
+
+    assert(ms >= 0 && ms < 150 && "A timed turn should reply before timeout_turn");
+}
+
+static void test_watchdog_replies_for_overrunning_search() {
+    OverrunningProtocol protocol;
+    std::thread reader([&] { protocol.run(); });
+
+    std::string setup = "START 15\nINFO timeout_turn 200\n";
+    protocol.send(setup);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    protocol.output(); // OK
+    std::string output;
+
+    std::string board = "BOARD\n7,7,2\n8,8,1\nDONE\n";
+    auto start = std::chrono::steady_clock::now();
+    protocol.send(board);
+    long ms = wait_for_move(protocol, output, start);
+    protocol.send("END\n");
+    reader.join();
+    output += protocol.output();
+
+    assert(ms >= 0 && ms < 200 && "The watchdog should reply before timeout_turn");
+    assert(output.find("DEBUG search overran") != std::string::npos && "The watchdog reply should be reported");
+    size_t comma = output.find(',');
+    assert(output.find(',', comma + 1) == std::string::npos && "The move should be sent exactly once");
+    int x = std::stoi(output.substr(0, comma));
+    int y = std::stoi(output.substr(comma + 1));
+    GomokuAI& ai = protocol.get_ai();
+    assert(ai.board[y * 15 + x] == 1 && "The board should hold the move the watchdog sent");
+}
+
+static void test_turn_after_overrun_keeps_its_deadline() {
+    OverrunningProtocol protocol;
+    std::thread reader([&] { protocol.run(); });
+
+    std::string setup = "START 15\nINFO timeout_turn 500\n";
+    protocol.send(setup);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    protocol.output(); // OK
+
+    std::string output;
+    std::string board = "BOARD\n7,7,2\n8,8,1\nDONE\n";
+    protocol.send(board);
+    assert(wait_for_move(protocol, output, std::chrono::steady_clock::now()) >= 0);
+
+    // The first search is still sleeping when the next turn starts; its wait counts
+    output.clear();
+    auto start = std::chrono::steady_clock::now();
+    protocol.send("TURN 3,3\n");
+    long ms = wait_for_move(protocol, output, start);
+    protocol.send("END\n");
+    reader.join();
+
+    assert(ms >= 0 && ms < 500 && "A turn should reply in time even after the previous search overran");
+}
+
+static void test_max_memory_is_in_kilobytes() {
+    std::string script = "START 15\nINFO max_memory 5000\n";
+
+    TestableProtocol protocol;
+    protocol.run_script(script);
+
+    MemoryUsage m = protocol.get_ai().memory_usage();
+    assert(m.total() <= 5000 * 1024 && m.tt >= (1 << 20) && "max_memory 5000 should give tables of a few MB");
+}
+
+static void test_max_nodes_takes_64_bit_values() {
+    std::string script = "INFO max_nodes 5000000000\nINFO max_nodes -1\nINFO max_nodes 12x\n";
+
+    TestableProtocol protocol;
+    protocol.run_script(script);
+
+    assert(protocol.search_limits().max_nodes == 5000000000ULL &&
+           "max_nodes above 2^31 should be kept, and invalid values ignored");
+}
+
+static void test_session_records_inputs_and_turns() {
+    std::string script = "START 15\nINFO timeout_turn 0 max_depth 2\nBOARD\n7,7,2\n8,8,1\nDONE\nTURN 6,6\n";
+
+    std::string path = "/tmp/test_protocol_session.bin";
+    {
+        TestableProtocol protocol;
+        assert(protocol.record_session(path) && "The session file should open");
+        protocol.run_script(script);
+    }
+
+    std::vector<SessionRecord> records;
+    assert(read_session(path, records) && "The session should read back");
+    std::string inputs;
+    std::vector<TurnRecord> turns;
+    uint64_t last_time = 0;
+    for (const SessionRecord& r : records) {
+        assert(r.time_us >= last_time && "Records should be in time order");
+        last_time = r.time_us;
+        if (r.type == SessionRecord::INPUT) inputs += r.line + "\n";
+        else turns.push_back(r.turn);
+    }
+    assert(inputs == script && "Every input line should be recorded");
+    assert(turns.size() == 2 && "Both turns should be recorded");
+    for (const TurnRecord& t : turns) {
+        assert(t.move.x >= 0 && t.depth >= 1 && t.nodes > 0 && t.budget_ms == 0 && !t.watchdog &&
+               t.reply_us >= t.think_us && "Turn stats should be recorded");
+    }
+
+    // A crash can tear the last record; the complete ones still read back
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    std::fwrite("\x01\x02", 1, 2, f);
+    std::fclose(f);
+    std::vector<SessionRecord> torn;
+    assert(read_session(path, torn) && torn.size() == records.size() && "A torn last record should be ignored");
+    std::remove(path.c_str());
+}
+
+// Runs `script` through a fresh protocol whose folder is `dir`
+static void run_in_folder(const TempDir& dir, const std::string& script) {
+    TestableProtocol protocol;
+    protocol.run_script("START 15\nINFO timeout_turn 0 max_depth 2 folder " + dir.path + "\n" + script + "END\n");
+}
+
+static void test_games_are_appended_at_end() {
+    TempDir dir;
+    run_in_folder(dir, "BEGIN\nTURN 1,1\n");
+    // We have four in a row and win; the opponent moved first
+    run_in_folder(dir, "BOARD\n10,10,2\n3,3,1\n12,12,2\n4,3,1\n10,12,2\n5,3,1\n12,10,2\n6,3,1\nDONE\n");
+
+    GameDB db;
+    assert(db.open(dir.path + "/gomoku.games") && db.size() == 2 && "Each game should be appended at END");
+    GameRecord g = db.game(0);
+    assert(g.board_size == 15 && g.first == "pbrain-gomoku-ai" && g.second == "opponent" && g.result == 0 &&
+           g.moves.size() == 3 && g.moves[0] == 7 * 15 + 7 && g.moves[1] == 1 * 15 + 1 &&
+           "The first game should list BEGIN's move, the opponent's and our reply");
+    g = db.game(1);
+    assert(g.first == "opponent" && g.moves.size() == 9 && g.moves[0] == 10 * 15 + 10 &&
+           g.moves[8] == 3 * 15 + 2 && g.result == 2 && "BOARD stones come in play order, then our winning move");
+}
+
+// turn_time_limit() once `script` has been run
+static int budget_after(const std::string& script) {
+    TestableProtocol protocol;
+    protocol.run_script(script);
+    return protocol.turn_time_limit();
+}
+
+static void test_time_left_is_shared_between_moves() {
+    int budget = budget_after("START 15\nINFO timeout_turn 0\nINFO time_left 100000\n");
+    assert(budget > 0 && budget <= 100000 / 15 && "Without timeout_turn a turn should take a share of time_left");
+    assert(budget_after("START 15\nINFO timeout_turn 1000 time_left 100000\n") == 1000 &&
+           "timeout_turn should cap the share");
+    assert(budget_after("START 15\nINFO timeout_turn 1000 time_left 2000\n") < 1000 &&
+           "A short match clock should shrink the turn");
+    assert(budget_after("START 15\nINFO timeout_turn 0\n") == 0 && "No limit at all means think until stopped");
+}
+
 int main() {
     std::cout << "Testing Protocol..." << std::endl;
 
+    // First: the MCTS arena kept by later tests counts against the budget
+    test_max_memory_is_in_kilobytes();
+    std::cout << "✓ max_memory in KB test passed" << std::endl;
+
     test_start_valid_size();
     std::cout << "✓ Valid size test passed" << std::endl;
 
     test_start_minimum_size();
     std::cout << "✓ Minimum size (5) test passed" << std::endl;
 
+    test_start_selects_backend();
+    std::cout << "✓ Backend selection test passed" << std::endl;
+
     test_start_unsupported_size_4();
     std::cout << "✓ Unsupported size (4) test passed" << std::endl;
 
@@ -233,6 +569,9 @@ int main() {
     test_start_large_size();
     std::cout << "✓ Large size test passed" << std::endl;
 
+    test_start_unsupported_size_too_large();
+    std::cout << "✓ Unsupported size (182) test passed" << std::endl;
+
     test_start_default_size();
     std::cout << "✓ Default size test passed" << std::endl;
 
@@ -245,6 +584,48 @@ int main() {
     test_begin_plays_first_move();
     std::cout << "✓ BEGIN plays first move test passed" << std::endl;
 
+    test_run_reads_board_from_fd();
+    std::cout << "✓ BOARD read through run() test passed" << std::endl;
+
+    test_history_survives_between_turns();
+    std::cout << "✓ History across turns test passed" << std::endl;
+
+    test_board_resync_applies_only_the_diff();
+    std::cout << "✓ BOARD re-sync test passed" << std::endl;
+
+    test_multipv_reports_lines();
+    std::cout << "✓ Multi-PV lines test passed" << std::endl;
+
+    test_info_selects_mcts();
+    std::cout << "✓ MCTS backend test passed" << std::endl;
+
+    test_perft_command();
+    std::cout << "✓ PERFT command test passed" << std::endl;
+
+    test_stop_interrupts_search();
+    std::cout << "✓ STOP interrupts search test passed" << std::endl;
+
+    test_timed_turn_replies_before_deadline();
+    std::cout << "✓ Timed turn deadline test passed" << std::endl;
+
+    test_watchdog_replies_for_overrunning_search();
+    std::cout << "✓ Watchdog reply test passed" << std::endl;
+
+    test_turn_after_overrun_keeps_its_deadline();
+    std::cout << "✓ Deadline after overrun test passed" << std::endl;
+
+    test_max_nodes_takes_64_bit_values();
+    std::cout << "✓ 64-bit max_nodes test passed" << std::endl;
+
+    test_session_records_inputs_and_turns();
+    std::cout << "✓ Session recording test passed" << std::endl;
+
+    test_time_left_is_shared_between_moves();
+    std::cout << "✓ time_left share test passed" << std::endl;
+
+    test_games_are_appended_at_end();
+    std::cout << "✓ Game file test passed" << std::endl;
+
     std::cout << "\nAll Protocol tests passed!" << std::endl;
     return 0;
 }
@@ -0,0 +1,65 @@
+#include "../src/GomokuAI.hpp"
+#include "../src/TrainingData.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static TrainingRecord sample_record(const GomokuAI& ai) {
+    TrainingRecord r;
+    r.stones = {3 * 9 + 4, 4 * 9 + 4, static_cast<uint16_t>((5 * 9 + 6) | TrainingRecord::OPPONENT_BIT)};
+    r.key = record_key(r, ai);
+    r.score = -1234;
+    r.best_move = 2 * 9 + 4;
+    r.result = -1;
+    r.depth = 3;
+    return r;
+}
+
+static void test_round_trip(const std::string& path) {
+    GomokuAI hasher;
+    hasher.init(9);
+    TrainingRecord r = sample_record(hasher);
+
+    TrainingWriter out;
+    assert(out.open(path, 9));
+    out.write(r);
+    out.write(r);
+    assert(out.close() && "Records should be written");
+
+    TrainingReader in;
+    assert(in.open(path) && in.board_size() == 9 && "Header should read back");
+    int count = 0;
+    for (TrainingRecord back; in.next(back); ++count) {
+        assert(back.key == r.key && back.score == r.score && back.best_move == r.best_move &&
+               back.result == r.result && back.depth == r.depth && back.stones == r.stones &&
+               "Record fields should survive a round trip");
+    }
+    assert(count == 2 && "Both records should be read");
+}
+
+static void test_symmetry_keys_match_engine() {
+    GomokuAI ai;
+    ai.init(9);
+    TrainingRecord r = sample_record(ai);
+
+    for (int sym = 0; sym < 8; ++sym) {
+        TrainingRecord t = transform_record(r, 9, sym, ai);
+        play_record(ai, t);
+        assert(ai.get_hash_key() == t.key && "Transformed key should match the engine's hash");
+        assert(ai.board[t.best_move] == 0 && "Best move should stay on an empty cell");
+        take_back_record(ai, t);
+        assert(ai.get_hash_key() == 0 && "Taking the record back should empty the board");
+    }
+    assert(transform_cell(0, 9, 1) == 8 && transform_cell(0, 9, 2) == 72 && transform_cell(1, 9, 4) == 9);
+}
+
+int main() {
+    std::string path = "/tmp/test_training_data_" + std::to_string(std::rand()) + ".bin";
+    test_round_trip(path);
+    test_symmetry_keys_match_engine();
+    std::remove(path.c_str());
+
+    std::cout << "All training data tests passed\n";
+    return 0;
+}
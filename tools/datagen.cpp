@@ -0,0 +1,190 @@
+// Self-play training data generator.
+//
+//   gomoku-datagen <out-file> [--games N] [--workers W] [--size S] [--depth D]
+//                  [--nodes M] [--opening K] [--seed X] [--no-augment]
+//
+// Every worker process plays its share of the games with a fixed search depth
+// (and node budget, if given). Those are reproducible searches, so the games
+// only depend on the seed and never read or write the proven-results store.
+// Each worker writes (position, score, best move, result) records to <out-file>.part<i>.
+// The parent then merges the parts into <out-file>, adding the 8 board
+// symmetries of each position and dropping duplicates by Zobrist key.
+#include "../src/GomokuAI.hpp"
+#include "../src/TrainingData.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Options {
+    std::string out;
+    int games = 100;
+    int workers = 1;
+    int size = 20;
+    int depth = 3;
+    uint64_t nodes = 0; // 0: no node limit
+    int opening = 6;
+    uint64_t seed = 1;
+    bool augment = true;
+};
+
+static TrainingRecord snapshot(const GomokuAI& ai) {
+    TrainingRecord r;
+    r.key = ai.get_hash_key();
+    for (int idx = 0; idx < ai.width * ai.height; ++idx) {
+        if (ai.board[idx] == 1) r.stones.push_back(static_cast<uint16_t>(idx));
+        else if (ai.board[idx] == 2) r.stones.push_back(static_cast<uint16_t>(idx) | TrainingRecord::OPPONENT_BIT);
+    }
+    return r;
+}
+
+// Plays one game; sides[c] sees its own stones as player 1
+static void play_game(GomokuAI sides[2], const Options& opt, std::mt19937_64& rng, TrainingWriter& out) {
+    SearchLimits limits;
+    limits.max_depth = opt.depth;
+    limits.max_nodes = opt.nodes;
+    int n = opt.size;
+    sides[0].init(n);
+    sides[1].init(n);
+    auto place = [&](int idx, int color) {
+        sides[color].update_board(idx % n, idx / n, 1);
+        sides[1 - color].update_board(idx % n, idx / n, 2);
+    };
+
+    // Random opening near the center
+    int c = n / 2;
+    std::uniform_int_distribution<int> near(-3, 3);
+    int turn = 0;
+    for (int i = 0; i < opt.opening; ++i, turn ^= 1) {
+        int idx;
+        do idx = std::clamp(c + near(rng), 0, n - 1) * n + std::clamp(c + near(rng), 0, n - 1);
+        while (sides[0].board[idx] != 0);
+        place(idx, turn);
+    }
+
+    std::vector<TrainingRecord> game;
+    std::vector<int> movers;
+    int winner = -1;
+    for (int moves = opt.opening; moves < n * n; ++moves, turn ^= 1) {
+        GomokuAI& ai = sides[turn];
+        Point p = ai.find_best_move(limits);
+        int idx = p.y * n + p.x;
+
+        TrainingRecord r = snapshot(ai);
+        r.score = ai.last_search().score;
+        r.depth = static_cast<uint8_t>(ai.last_search().depth);
+        r.best_move = static_cast<int16_t>(idx);
+        game.push_back(std::move(r));
+        movers.push_back(turn);
+
+        place(idx, turn);
+        if (ai.is_five(idx)) {
+            winner = turn;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < game.size(); ++i) {
+        game[i].result = static_cast<int8_t>(winner < 0 ? 0 : (movers[i] == winner ? 1 : -1));
+        out.write(game[i]);
+    }
+}
+
+static void run_worker(const Options& opt, int worker) {
+    TrainingWriter out;
+    if (!out.open(opt.out + ".part" + std::to_string(worker), opt.size)) std::exit(1);
+
+    GomokuAI sides[2];
+    for (int g = worker; g < opt.games; g += opt.workers) {
+        std::mt19937_64 rng(opt.seed * 1000003 + static_cast<uint64_t>(g));
+        play_game(sides, opt, rng, out);
+    }
+    std::exit(out.close() ? 0 : 1);
+}
+
+// Concatenates the worker parts, with symmetry augmentation and de-duplication
+static bool merge(const Options& opt, uint64_t& read, uint64_t& written) {
+    TrainingWriter out;
+    if (!out.open(opt.out, opt.size)) return false;
+    GomokuAI hasher;
+    hasher.init(opt.size);
+    std::unordered_set<uint64_t> seen;
+    int syms = opt.augment ? 8 : 1;
+
+    for (int w = 0; w < opt.workers; ++w) {
+        std::string part = opt.out + ".part" + std::to_string(w);
+        TrainingReader in;
+        if (!in.open(part)) return false;
+        for (TrainingRecord r; in.next(r);) {
+            ++read;
+            for (int sym = 0; sym < syms; ++sym) {
+                TrainingRecord t = sym == 0 ? r : transform_record(r, opt.size, sym, hasher);
+                if (seen.insert(t.key).second) {
+                    out.write(t);
+                    ++written;
+                }
+            }
+        }
+        std::remove(part.c_str());
+    }
+    return out.close();
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() { return i + 1 < argc ? std::atoll(argv[++i]) : 0; };
+        if (a == "--games") opt.games = static_cast<int>(value());
+        else if (a == "--workers") opt.workers = static_cast<int>(value());
+        else if (a == "--size") opt.size = static_cast<int>(value());
+        else if (a == "--depth") opt.depth = static_cast<int>(value());
+        else if (a == "--nodes") opt.nodes = static_cast<uint64_t>(value());
+        else if (a == "--opening") opt.opening = static_cast<int>(value());
+        else if (a == "--seed") opt.seed = static_cast<uint64_t>(value());
+        else if (a == "--no-augment") opt.augment = false;
+        else if (opt.out.empty() && a[0] != '-') opt.out = a;
+        else return false;
+    }
+    return !opt.out.empty() && opt.games > 0 && opt.workers > 0 && opt.depth > 0 && opt.size >= 5 && opt.size <= 128 &&
+           opt.opening >= 0 && opt.opening < opt.size * opt.size;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " <out-file> [--games N] [--workers W] [--size S] [--depth D]"
+                  << " [--nodes M] [--opening K] [--seed X] [--no-augment]\n";
+        return 2;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    for (int w = 0; w < opt.workers; ++w) {
+        pid_t pid = fork();
+        if (pid < 0) return 1;
+        if (pid == 0) run_worker(opt, w);
+    }
+    bool ok = true;
+    for (int w = 0; w < opt.workers; ++w) {
+        int status = 0;
+        wait(&status);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    uint64_t read = 0, written = 0;
+    if (!ok || !merge(opt, read, written)) {
+        std::cerr << "datagen failed\n";
+        return 1;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << opt.games << " games, " << read << " positions, " << written << " records after augmentation/dedup, "
+              << secs << " s (" << static_cast<uint64_t>(read / secs * 3600) << " positions/hour)\n";
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Microbenchmarks of the engine's hot kernels.
+//
+//   gomoku-microbench [--size S] [--games G] [--reps R] [--warmup W]
+//                     [--cpu C] [--seed X]
+//
+// Builds a corpus of realistic positions from G short games (each move is one
+// of the four best ordered candidates, picked with a seeded RNG), pins itself
+// to CPU C and times every kernel over the whole corpus: W untimed passes,
+// then R timed ones. Prints the cost per call (TSC cycles on x86, otherwise
+// nanoseconds) as mean, standard deviation and minimum over the repetitions.
+#include "../src/GomokuAI.hpp"
+#include "../src/Search.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+static uint64_t ticks() { return __rdtsc(); }
+static const char* const TICK_UNIT = "cycles";
+#else
+static uint64_t ticks() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+static const char* const TICK_UNIT = "ns";
+#endif
+
+struct Options {
+    int size = 20;
+    int games = 32;
+    int reps = 15;
+    int warmup = 3;
+    int cpu = 0;
+    uint64_t seed = 1;
+};
+
+// One kernel: runs it on a position and returns how many calls that made
+struct Kernel {
+    const char* name;
+    std::function<uint64_t(GomokuAI&, uint64_t&)> run;
+};
+
+// Positions with 6 to 80 stones, every 4th one of each game
+static std::vector<GomokuAI> build_corpus(const Options& opt) {
+    std::mt19937_64 rng(opt.seed);
+    std::vector<GomokuAI> corpus;
+    for (int g = 0; g < opt.games; ++g) {
+        GomokuAI ai;
+        ai.init(opt.size);
+        ai.update_board(opt.size / 2, opt.size / 2, 1);
+        for (int ply = 1, player = 2; ply < 80; ++ply, player = 3 - player) {
+            auto moves = get_sorted_moves(ai, player, 0);
+            if (moves.empty()) break;
+            int idx = moves[rng() % std::min<size_t>(4, moves.size())].second;
+            ai.update_board(idx % ai.width, idx / ai.width, player);
+            if (ai.is_five(idx)) break;
+            if (ply >= 6 && ply % 4 == 0) corpus.push_back(ai);
+        }
+    }
+    return corpus;
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() { return i + 1 < argc ? std::atoll(argv[++i]) : 0; };
+        if (a == "--size") opt.size = static_cast<int>(value());
+        else if (a == "--games") opt.games = static_cast<int>(value());
+        else if (a == "--reps") opt.reps = static_cast<int>(value());
+        else if (a == "--warmup") opt.warmup = static_cast<int>(value());
+        else if (a == "--cpu") opt.cpu = static_cast<int>(value());
+        else if (a == "--seed") opt.seed = static_cast<uint64_t>(value());
+        else return false;
+    }
+    return opt.size >= 5 && opt.size <= MAX_BOARD_SIZE && opt.games > 0 && opt.reps > 0 && opt.warmup >= 0 &&
+           opt.cpu >= 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " [--size S] [--games G] [--reps R] [--warmup W] [--cpu C] [--seed X]\n";
+        return 2;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(opt.cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) std::cerr << "warning: cannot pin to CPU " << opt.cpu << "\n";
+
+    std::vector<GomokuAI> corpus = build_corpus(opt);
+    std::cout << corpus.size() << " positions on " << opt.size << "x" << opt.size << ", " << opt.reps
+              << " reps after " << opt.warmup << " warmup passes, " << TICK_UNIT << " per call\n";
+
+    // Board updates undo themselves so every pass sees the same corpus
+    const size_t UPDATES = 8;
+    std::vector<Kernel> kernels = {
+        {"check_win", [](GomokuAI& ai, uint64_t& sink) {
+             for (int idx : ai.stones()) sink += check_win(ai.board, idx, ai.width, ai.height, ai.board[idx]);
+             return static_cast<uint64_t>(ai.stones().size());
+         }},
+        {"score_move", [](GomokuAI& ai, uint64_t& sink) {
+             for (int idx : ai.candidates()) sink += static_cast<uint64_t>(score_move(ai, idx, 1, 0));
+             return static_cast<uint64_t>(ai.candidates().size());
+         }},
+        {"eval_state", [](GomokuAI& ai, uint64_t& sink) {
+             sink += static_cast<uint64_t>(eval_state(ai, 1));
+             return uint64_t(1);
+         }},
+        {"get_sorted_moves", [](GomokuAI& ai, uint64_t& sink) {
+             sink += get_sorted_moves(ai, 1, 0).size();
+             return uint64_t(1);
+         }},
+        {"forced_replies", [](GomokuAI& ai, uint64_t& sink) {
+             sink += forced_replies(ai, 1).size();
+             return uint64_t(1);
+         }},
+        {"update_board", [&](GomokuAI& ai, uint64_t& sink) {
+             std::vector<int> cells(ai.candidates().begin(), ai.candidates().end());
+             cells.resize(std::min(cells.size(), UPDATES));
+             for (int idx : cells) {
+                 ai.update_board(idx % ai.width, idx / ai.width, 1);
+                 ai.update_board(idx % ai.width, idx / ai.width, 0);
+             }
+             sink += ai.get_hash_key();
+             return static_cast<uint64_t>(2 * cells.size());
+         }},
+        {"make+unmake_move", [&](GomokuAI& ai, uint64_t& sink) {
+             std::vector<int> cells(ai.candidates().begin(), ai.candidates().end());
+             cells.resize(std::min(cells.size(), UPDATES));
+             for (int idx : cells) {
+                 ai.make_move(idx, 1);
+                 ai.unmake_move();
+             }
+             sink += ai.get_hash_key();
+             return static_cast<uint64_t>(cells.size());
+         }},
+    };
+
+    uint64_t sink = 0;
+    std::printf("%-18s %12s %10s %10s %10s\n", "kernel", "calls/rep", "mean", "stddev", "min");
+    for (Kernel& k : kernels) {
+        std::vector<double> per_call;
+        uint64_t calls = 0;
+        for (int rep = -opt.warmup; rep < opt.reps; ++rep) {
+            calls = 0;
+            uint64_t start = ticks();
+            for (GomokuAI& ai : corpus) calls += k.run(ai, sink);
+            uint64_t elapsed = ticks() - start;
+            if (rep >= 0 && calls > 0) per_call.push_back(static_cast<double>(elapsed) / static_cast<double>(calls));
+        }
+        if (per_call.empty()) continue;
+        double mean = 0;
+        for (double v : per_call) mean += v;
+        mean /= static_cast<double>(per_call.size());
+        double var = 0;
+        for (double v : per_call) var += (v - mean) * (v - mean);
+        double stddev = std::sqrt(var / static_cast<double>(per_call.size()));
+        double best = *std::min_element(per_call.begin(), per_call.end());
+        std::printf("%-18s %12llu %10.1f %10.1f %10.1f\n", k.name, static_cast<unsigned long long>(calls), mean,
+                    stddev, best);
+    }
+    // Keeps the kernels' results alive
+    if (sink == 42) std::cout << "\n";
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Move generator node enumeration ("perft").
+//
+//   gomoku-perft <depth> [--size S] [--threads N] [x,y,p ...]
+//
+// Sets up the stones given as x,y,player (player 1 moves next; by default a
+// single opponent stone in the center) and enumerates the candidate tree at
+// each depth from 1 to <depth>, printing leaf and node counts with the node
+// rate. The counts are fixed for a given generator, so a change to the board
+// core that alters them is a bug.
+#include "../src/GomokuAI.hpp"
+#include "../src/Perft.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Options {
+    int depth = 0;
+    int size = 15;
+    int threads = 1;
+    std::vector<std::string> stones;
+};
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() { return i + 1 < argc ? std::atoi(argv[++i]) : 0; };
+        if (a == "--size") opt.size = value();
+        else if (a == "--threads") opt.threads = value();
+        else if (a[0] == '-') return false;
+        else if (opt.depth == 0) opt.depth = std::atoi(a.c_str());
+        else opt.stones.push_back(a);
+    }
+    return opt.depth > 0 && opt.size >= 5 && opt.size <= MAX_BOARD_SIZE && opt.threads > 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " <depth> [--size S] [--threads N] [x,y,p ...]\n";
+        return 2;
+    }
+
+    GomokuAI ai;
+    ai.init(opt.size);
+    if (opt.stones.empty()) ai.update_board(opt.size / 2, opt.size / 2, 2);
+    for (const std::string& s : opt.stones) {
+        int x, y, p;
+        if (std::sscanf(s.c_str(), "%d,%d,%d", &x, &y, &p) != 3 || x < 0 || x >= opt.size || y < 0 ||
+            y >= opt.size || p < 1 || p > 2) {
+            std::cerr << "bad stone " << s << "\n";
+            return 2;
+        }
+        ai.update_board(x, y, p);
+    }
+
+    for (int d = 1; d <= opt.depth; ++d) {
+        PerftResult r = perft(ai, d, 1, opt.threads);
+        std::cout << "depth " << d << " leaves " << r.leaves << " nodes " << r.nodes << " time "
+                  << static_cast<uint64_t>(r.seconds * 1000) << " ms knps "
+                  << static_cast<uint64_t>(r.seconds > 0 ? r.nodes / r.seconds / 1000 : 0) << "\n";
+    }
+    return 0;
+}
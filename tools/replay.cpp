@@ -0,0 +1,142 @@
+// Replays a recorded protocol session (PBRAIN_SESSION) through Protocol.
+//
+//   gomoku-replay <session> [--fast] [--record <out>]
+//
+// Feeds the recorded input lines to a fresh Protocol at the times they
+// originally arrived (--fast: all at once, which cuts searches short when a
+// STOP or END arrives early), records the replay to <out> (default
+// <session>.replay) and prints every turn of both sessions side by side.
+// Evaluation files are loaded as the brain does. The proven-results store is
+// not: the replay starts with an empty one and never saves it, and `INFO
+// folder` is dropped, so a replay neither depends on nor changes any store.
+#include "../src/Protocol.hpp"
+#include "../src/Session.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// `line` without the `folder` key of an INFO command
+static std::string without_folder(const std::string& line) {
+    if (line.rfind("INFO", 0) != 0) return line;
+    std::istringstream in(line);
+    std::string out, key, value;
+    in >> out; // INFO
+    while (in >> key) {
+        in >> value;
+        if (key != "folder") out += " " + key + " " + value;
+    }
+    return out;
+}
+
+static void write_all(int fd, const std::string& s) {
+    for (size_t done = 0; done < s.size();) {
+        ssize_t n = ::write(fd, s.data() + done, s.size() - done);
+        if (n <= 0) return;
+        done += static_cast<size_t>(n);
+    }
+}
+
+static std::vector<TurnRecord> turns_of(const std::vector<SessionRecord>& records) {
+    std::vector<TurnRecord> turns;
+    for (const SessionRecord& r : records) {
+        if (r.type == SessionRecord::TURN) turns.push_back(r.turn);
+    }
+    return turns;
+}
+
+static void print_turn(const TurnRecord& t) {
+    std::printf("%3d,%-3d %5d %10llu %11d %8.1f %8.1f%s", t.move.x, t.move.y, t.depth,
+                static_cast<unsigned long long>(t.nodes), t.score, t.think_us / 1000.0, t.reply_us / 1000.0,
+                t.watchdog ? " W" : "  ");
+}
+
+int main(int argc, char** argv) {
+    std::string path, out_path;
+    bool fast = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--fast") fast = true;
+        else if (a == "--record" && i + 1 < argc) out_path = argv[++i];
+        else if (path.empty() && a.rfind("--", 0) != 0) path = a;
+        else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: " << argv[0] << " <session> [--fast] [--record <out>]\n";
+        return 2;
+    }
+    if (out_path.empty()) out_path = path + ".replay";
+
+    std::vector<SessionRecord> original;
+    if (!read_session(path, original)) {
+        std::cerr << "cannot read session " << path << "\n";
+        return 1;
+    }
+
+    const char* params_path = std::getenv("PBRAIN_PARAMS");
+    load_eval_params(params_path ? params_path : "gomoku.params");
+    const char* nnue_path = std::getenv("PBRAIN_NNUE");
+    load_nnue(nnue_path ? nnue_path : "gomoku.nnue");
+
+    int in[2];
+    int sink = ::open("/dev/null", O_WRONLY);
+    if (pipe(in) != 0 || sink < 0) {
+        std::cerr << "cannot set up the replay\n";
+        return 1;
+    }
+    {
+        Protocol protocol(in[0], sink);
+        if (!protocol.record_session(out_path)) {
+            std::cerr << "cannot write " << out_path << "\n";
+            return 1;
+        }
+        std::thread brain([&] { protocol.run(); });
+        auto start = std::chrono::steady_clock::now();
+        for (const SessionRecord& r : original) {
+            if (r.type != SessionRecord::INPUT) continue;
+            if (!fast) std::this_thread::sleep_until(start + std::chrono::microseconds(r.time_us));
+            write_all(in[1], without_folder(r.line) + "\n");
+        }
+        ::close(in[1]);
+        brain.join();
+    }
+    ::close(in[0]);
+    ::close(sink);
+
+    std::vector<SessionRecord> replayed;
+    read_session(out_path, replayed);
+    std::vector<TurnRecord> a = turns_of(original), b = turns_of(replayed);
+
+    std::printf("%4s | %-7s %5s %10s %11s %8s %8s   | %-7s %5s %10s %11s %8s %8s\n", "turn", "move", "depth",
+                "nodes", "score", "think", "reply", "move", "depth", "nodes", "score", "think", "reply");
+    size_t n = std::max(a.size(), b.size());
+    int differ = 0;
+    uint32_t worst_a = 0, worst_b = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::printf("%4zu | ", i + 1);
+        if (i < a.size()) print_turn(a[i]);
+        else std::printf("%-62s", "-");
+        std::printf(" | ");
+        if (i < b.size()) print_turn(b[i]);
+        else std::printf("-");
+        bool same = i < a.size() && i < b.size() && a[i].move.x == b[i].move.x && a[i].move.y == b[i].move.y;
+        differ += !same;
+        std::printf("%s\n", same ? "" : "  <- differs");
+        if (i < a.size()) worst_a = std::max(worst_a, a[i].reply_us);
+        if (i < b.size()) worst_b = std::max(worst_b, b[i].reply_us);
+    }
+    std::printf("%zu turns recorded, %zu replayed, %d differ; slowest reply %.1f ms recorded, %.1f ms replayed\n",
+                a.size(), b.size(), differ, worst_a / 1000.0, worst_b / 1000.0);
+    std::printf("times in ms from the command, W: sent by the watchdog\n");
+    return 0;
+}
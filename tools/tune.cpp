@@ -0,0 +1,211 @@
+// Texel-style tuner for EvalParams.
+//
+//   gomoku-tune <corpus> [--out FILE] [--params FILE] [--threads N]
+//               [--iterations N] [--limit N] [--target eval|ordering]
+//
+// eval:     fits the eval_state weights so that sigmoid(K * eval) predicts the
+//           game result of each corpus position (K is fitted first).
+// ordering: fits the score_move weights so that the best-scored candidate is
+//           the move the search chose.
+// Both use coordinate descent with a shrinking relative step; the corpus is
+// evaluated in parallel batches, one GomokuAI per thread. The parameters are
+// written to --out (default tuned.params) after every improving pass.
+#include "../src/EvalParams.hpp"
+#include "../src/GomokuAI.hpp"
+#include "../src/TrainingData.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+    std::string corpus;
+    std::string out = "tuned.params";
+    std::string params;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int iterations = 50;
+    size_t limit = 0;
+    bool ordering = false;
+};
+
+class Tuner {
+public:
+    Tuner(std::vector<TrainingRecord> corpus, int size, int threads) : corpus(std::move(corpus)), engines(threads) {
+        for (auto& ai : engines) ai.init(size);
+    }
+
+    // Mean squared error between game results and sigmoid(k * eval)
+    double eval_loss(const EvalParams& params, double k) {
+        return batched(params, [k](GomokuAI& ai, const TrainingRecord& r) {
+            double target = (r.result + 1) / 2.0;
+            double predicted = 1.0 / (1.0 + std::exp(-k * ai.static_eval(1)));
+            return (target - predicted) * (target - predicted);
+        });
+    }
+
+    // Fraction of positions where the top tactical score is not the searched best move
+    double ordering_loss(const EvalParams& params) {
+        return batched(params, [](GomokuAI& ai, const TrainingRecord& r) {
+            int best_idx = -1;
+            int best_score = 0;
+            for (int idx = 0; idx < ai.width * ai.height; ++idx) {
+                if (ai.board[idx] != 0 || ai.neighbors[idx] == 0) continue;
+                int score = ai.tactical_move_score(idx, 1);
+                if (best_idx == -1 || score > best_score) {
+                    best_idx = idx;
+                    best_score = score;
+                }
+            }
+            return best_idx == r.best_move ? 0.0 : 1.0;
+        });
+    }
+
+private:
+    std::vector<TrainingRecord> corpus;
+    std::vector<GomokuAI> engines;
+
+    double batched(const EvalParams& params, const std::function<double(GomokuAI&, const TrainingRecord&)>& term) {
+        int threads = static_cast<int>(engines.size());
+        std::vector<double> partial(threads, 0.0);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                GomokuAI& ai = engines[t];
+                ai.params = params;
+                size_t begin = corpus.size() * t / threads;
+                size_t end = corpus.size() * (t + 1) / threads;
+                double sum = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    play_record(ai, corpus[i]);
+                    sum += term(ai, corpus[i]);
+                    take_back_record(ai, corpus[i]);
+                }
+                partial[t] = sum;
+            });
+        }
+        for (auto& th : pool) th.join();
+        double total = 0;
+        for (double p : partial) total += p;
+        return corpus.empty() ? 0 : total / static_cast<double>(corpus.size());
+    }
+};
+
+// Golden-section search for the sigmoid scale, over log10(k)
+static double fit_k(Tuner& tuner, const EvalParams& params) {
+    const double phi = (std::sqrt(5.0) - 1) / 2;
+    double lo = -8, hi = 0;
+    double a = hi - phi * (hi - lo), b = lo + phi * (hi - lo);
+    double la = tuner.eval_loss(params, std::pow(10, a));
+    double lb = tuner.eval_loss(params, std::pow(10, b));
+    for (int i = 0; i < 30; ++i) {
+        if (la < lb) {
+            hi = b; b = a; lb = la;
+            a = hi - phi * (hi - lo);
+            la = tuner.eval_loss(params, std::pow(10, a));
+        } else {
+            lo = a; a = b; la = lb;
+            b = lo + phi * (hi - lo);
+            lb = tuner.eval_loss(params, std::pow(10, b));
+        }
+    }
+    return std::pow(10, (lo + hi) / 2);
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+        if (a == "--out") opt.out = value();
+        else if (a == "--params") opt.params = value();
+        else if (a == "--threads") opt.threads = std::atoi(value().c_str());
+        else if (a == "--iterations") opt.iterations = std::atoi(value().c_str());
+        else if (a == "--limit") opt.limit = static_cast<size_t>(std::atoll(value().c_str()));
+        else if (a == "--target") {
+            std::string t = value();
+            if (t != "eval" && t != "ordering") return false;
+            opt.ordering = t == "ordering";
+        }
+        else if (opt.corpus.empty() && a[0] != '-') opt.corpus = a;
+        else return false;
+    }
+    return !opt.corpus.empty() && opt.threads > 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " <corpus> [--out FILE] [--params FILE] [--threads N]"
+                  << " [--iterations N] [--limit N] [--target eval|ordering]\n";
+        return 2;
+    }
+
+    EvalParams params;
+    if (!opt.params.empty() && !params.load(opt.params)) {
+        std::cerr << "cannot read " << opt.params << "\n";
+        return 1;
+    }
+
+    TrainingReader reader;
+    if (!reader.open(opt.corpus)) {
+        std::cerr << "cannot read " << opt.corpus << "\n";
+        return 1;
+    }
+    std::vector<TrainingRecord> corpus;
+    for (TrainingRecord r; (opt.limit == 0 || corpus.size() < opt.limit) && reader.next(r);) {
+        if (!opt.ordering || r.best_move >= 0) corpus.push_back(r);
+    }
+    std::cout << corpus.size() << " positions, " << opt.threads << " threads\n";
+
+    auto start = std::chrono::steady_clock::now();
+    Tuner tuner(std::move(corpus), reader.board_size(), opt.threads);
+    double k = opt.ordering ? 0 : fit_k(tuner, params);
+    auto loss = [&](const EvalParams& p) { return opt.ordering ? tuner.ordering_loss(p) : tuner.eval_loss(p, k); };
+    if (!opt.ordering) std::cout << "K = " << k << "\n";
+
+    // Only the weights the chosen target can measure are tuned
+    std::vector<size_t> tuned;
+    auto names = params.fields();
+    for (size_t i = 0; i < names.size(); ++i) {
+        bool move_field = std::strncmp(names[i].first, "move_", 5) == 0;
+        if (move_field == opt.ordering) tuned.push_back(i);
+    }
+
+    double best = loss(params);
+    std::cout << "start loss " << best << "\n";
+    double step = 0.25;
+    for (int iter = 1; iter <= opt.iterations && step >= 0.005; ++iter) {
+        bool improved = false;
+        for (size_t i : tuned) {
+            for (int dir : {1, -1}) {
+                EvalParams candidate = params;
+                int& v = *candidate.fields()[i].second;
+                v = std::clamp(v + dir * std::max(1, static_cast<int>(v * step)), 1, 100000000);
+                double l = loss(candidate);
+                if (l < best) {
+                    best = l;
+                    params = candidate;
+                    improved = true;
+                    break;
+                }
+            }
+        }
+        if (improved) params.save(opt.out);
+        else step /= 2;
+
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "pass " << iter << ": loss " << best << ", step " << step << ", " << secs << " s\n";
+    }
+
+    if (!params.save(opt.out)) {
+        std::cerr << "cannot write " << opt.out << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << opt.out << "\n";
+    return 0;
+}